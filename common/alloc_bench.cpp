@@ -0,0 +1,172 @@
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstring>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#include "grid_alloc.hpp"
+
+// Start-up cost and TLB behaviour of a task6-sized grid:
+//  * std::vector(n) + init: value-initialisation zeroes the grid, init writes it again;
+//  * grid_alloc::vector + firstTouch: one parallel write, 4 KB pages;
+//  * the same with transparent huge pages;
+//  * repeated allocations served from the pool.
+// Each case is followed by strided stencil-like reads over the grid, the
+// access pattern that suffers most from TLB misses. Page faults come from the
+// software counter; dTLB misses are reported when the PMU exposes them.
+// usage: alloc_bench [MB] [threads]
+
+using Clock = std::chrono::steady_clock;
+
+class Counter {
+private:
+    int fd = -1;
+public:
+    Counter(uint32_t type, uint64_t config) {
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = type;
+        attr.config = config;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.inherit = 1;
+        fd = syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+    }
+    ~Counter() {
+        if (fd >= 0)
+            close(fd);
+    }
+    bool ok() const {
+        return fd >= 0;
+    }
+    void start() {
+        if (fd >= 0)
+        {
+            ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+            ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+    }
+    long long stop() {
+        long long v = -1;
+        if (fd >= 0)
+        {
+            ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+            if (read(fd, &v, sizeof(v)) != sizeof(v))
+                v = -1;
+        }
+        return v;
+    }
+};
+
+long anonHugeKB() {
+    std::ifstream f("/proc/self/smaps_rollup");
+    std::string line;
+    while (std::getline(f, line))
+        if (line.compare(0, 14, "AnonHugePages:") == 0)
+            return std::atol(line.c_str() + 14);
+    return -1;
+}
+
+void initGrid(double* a, size_t b, size_t e, size_t N) {
+    for (size_t k = b; k < e; k++)
+    {
+        size_t i = k / N, j = k % N;
+        a[k] = (i == 0 || j == 0 || i == N-1 || j == N-1) ? 10.0 : 0.0;
+    }
+}
+
+// Column-wise 5-point sums: every access is N doubles from the previous one,
+// so each one lands on a different 4 KB page.
+double columnSweep(const double* a, size_t N) {
+    double s = 0.0;
+    for (size_t j = 1; j < N-1; j += 7)
+        for (size_t i = 1; i < N-1; i++)
+            s += a[i*N+j-1] + a[i*N+j+1] + a[(i-1)*N+j] + a[(i+1)*N+j];
+    return s;
+}
+
+struct Row {
+    std::string name;
+    double initMs, sweepMs;
+    long long faults, tlb;
+    long hugeKB;
+};
+
+template <class Alloc>
+Row measure(const std::string& name, size_t N, Alloc alloc) {
+    Counter faults(PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS);
+    Counter tlb(PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16));
+    Row r{name, 0, 0, -1, -1, -1};
+    faults.start();
+    auto t = Clock::now();
+    auto grid = alloc();
+    r.initMs = std::chrono::duration<double, std::milli>(Clock::now() - t).count();
+    r.faults = faults.stop();
+    r.hugeKB = anonHugeKB();
+    tlb.start();
+    t = Clock::now();
+    volatile double s = columnSweep(grid.data(), N);
+    (void)s;
+    r.sweepMs = std::chrono::duration<double, std::milli>(Clock::now() - t).count();
+    r.tlb = tlb.stop();
+    return r;
+}
+
+int main(int argc, char const *argv[])
+{
+    size_t mb = argc > 1 ? std::atol(argv[1]) : 1024;
+    int threads = argc > 2 ? std::atoi(argv[2]) : std::thread::hardware_concurrency();
+    size_t N = 1;
+    while ((N + 1) * (N + 1) * sizeof(double) <= mb << 20)
+        N++;
+    size_t len = N * N;
+
+    std::vector<Row> rows;
+    rows.push_back(measure("std::vector + init", N, [&]() {
+        std::vector<double> v(len);
+        initGrid(v.data(), 0, len, N);
+        return v;
+    }));
+    grid_alloc::Pool::instance().trim();
+    grid_alloc::hugePages() = grid_alloc::HugePages::Off;
+    rows.push_back(measure("firstTouch, 4K pages", N, [&]() {
+        grid_alloc::vector<double> v(len);
+        grid_alloc::firstTouch<double>(len, [&](size_t b, size_t e) { initGrid(v.data(), b, e, N); }, threads);
+        return v;
+    }));
+    grid_alloc::Pool::instance().trim();
+    grid_alloc::hugePages() = grid_alloc::HugePages::Transparent;
+    for (int rep = 0; rep < 3; rep++)
+    {
+        rows.push_back(measure(rep == 0 ? "firstTouch, THP" : "firstTouch, THP, pooled", N, [&]() {
+            grid_alloc::vector<double> v(len);
+            grid_alloc::firstTouch<double>(len, [&](size_t b, size_t e) { initGrid(v.data(), b, e, N); }, threads);
+            return v;
+        }));
+    }
+
+    auto& pool = grid_alloc::Pool::instance();
+    std::cout << "N = " << N << " (" << len * sizeof(double) / (1 << 20) << " MB), " << threads << " threads" << std::endl;
+    std::cout << std::left << std::setw(26) << "allocation" << std::right << std::setw(10) << "init, ms"
+              << std::setw(10) << "faults" << std::setw(12) << "huge, MB" << std::setw(11) << "sweep, ms"
+              << std::setw(14) << "dTLB misses" << std::endl;
+    std::cout << std::fixed << std::setprecision(1);
+    for (const Row& r : rows)
+    {
+        std::cout << std::left << std::setw(26) << r.name << std::right << std::setw(10) << r.initMs
+                  << std::setw(10) << r.faults << std::setw(12) << (r.hugeKB >= 0 ? r.hugeKB / 1024 : -1) << std::setw(11) << r.sweepMs;
+        if (r.tlb >= 0)
+            std::cout << std::setw(14) << r.tlb << std::endl;
+        else
+            std::cout << std::setw(14) << "n/a" << std::endl;
+    }
+    std::cout << "pool: " << pool.hits.load() << " hits, " << pool.misses.load() << " misses" << std::endl;
+    return 0;
+}
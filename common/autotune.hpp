@@ -0,0 +1,237 @@
+#pragma once
+// Launch parameters (threads, schedule, chunk, tile sizes, ...) picked by a
+// short calibration sweep and remembered per machine.
+//
+//   autotune::Space space = {{"threads", autotune::threadCounts()}, {"chunk", {0, 64, 512}}};
+//   autotune::Config c = autotune::select("task2.3/solver", n, space, [&](const autotune::Config& c) {
+//       ... one short run with c.at("threads"), c.at("chunk") ...
+//   });
+//
+// AUTOTUNE selects the mode:
+//   unset/use  the profile's winner for (kernel, size bucket), else the
+//              defaults (the first value of every parameter);
+//   tune       time every combination (best of `reps` after a warm-up run),
+//              store the fastest in the profile and save it;
+//   off        always the defaults.
+// The profile is a text file, AUTOTUNE_PROFILE or
+// $HOME/.cache/paralel/tune-<hostname>.txt, one line per kernel and bucket:
+//   <kernel> <bucket> <seconds> <param>=<value> ...
+// Sizes are bucketed to the power of two at or below them, so nearby sizes
+// share one entry.
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace autotune {
+
+enum class Mode { Off, Use, Tune };
+
+inline Mode mode() {
+    const char* env = std::getenv("AUTOTUNE");
+    if (env && std::strcmp(env, "tune") == 0)
+        return Mode::Tune;
+    if (env && std::strcmp(env, "off") == 0)
+        return Mode::Off;
+    return Mode::Use;
+}
+
+using Config = std::map<std::string, long>;
+
+struct Param {
+    std::string name;
+    std::vector<long> values;       // values[0] is the default
+};
+using Space = std::vector<Param>;
+
+inline Config defaults(const Space& space) {
+    Config c;
+    for (const Param& p : space)
+        c[p.name] = p.values.at(0);
+    return c;
+}
+
+// Every combination, the defaults first.
+inline std::vector<Config> candidates(const Space& space) {
+    std::vector<Config> all(1);
+    for (const Param& p : space)
+    {
+        std::vector<Config> next;
+        for (const Config& c : all)
+            for (long v : p.values)
+            {
+                Config e = c;
+                e[p.name] = v;
+                next.push_back(e);
+            }
+        all.swap(next);
+    }
+    return all;
+}
+
+inline long bucket(size_t size) {
+    long b = 1;
+    while (size_t(b) * 2 <= size)
+        b *= 2;
+    return b;
+}
+
+// The hardware thread count first, then 1, 2, 4, ... up to twice it.
+inline std::vector<long> threadCounts() {
+    long hw = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<long> v = {hw};
+    for (long t = 1; t <= 2 * hw; t *= 2)
+        if (t != hw)
+            v.push_back(t);
+    return v;
+}
+
+inline std::string format(const Config& c) {
+    std::string s;
+    for (const auto& kv : c)
+        s += (s.empty() ? "" : " ") + kv.first + "=" + std::to_string(kv.second);
+    return s;
+}
+
+inline std::string profilePath() {
+    if (const char* env = std::getenv("AUTOTUNE_PROFILE"))
+        return env;
+    char host[256] = "localhost";
+    gethostname(host, sizeof(host) - 1);
+    const char* home = std::getenv("HOME");
+    return std::string(home ? home : ".") + "/.cache/paralel/tune-" + host + ".txt";
+}
+
+class Profile {
+private:
+    struct Entry {
+        double seconds;
+        Config config;
+    };
+    std::string path;
+    std::map<std::pair<std::string, long>, Entry> entries;
+    std::mutex mut;
+
+    explicit Profile(std::string file) : path(std::move(file)) {
+        std::ifstream in(path);
+        std::string line;
+        while (std::getline(in, line))
+        {
+            std::istringstream ls(line);
+            std::string kernel, kv;
+            long b;
+            Entry e;
+            if (line.empty() || line[0] == '#' || !(ls >> kernel >> b >> e.seconds))
+                continue;
+            while (ls >> kv)
+            {
+                size_t eq = kv.find('=');
+                if (eq != std::string::npos)
+                    e.config[kv.substr(0, eq)] = std::atol(kv.c_str() + eq + 1);
+            }
+            entries[{kernel, b}] = e;
+        }
+    }
+
+public:
+    static Profile& machine() {
+        static Profile p(profilePath());
+        return p;
+    }
+
+    // The stored configuration if it sets every parameter of `space` to one of its values.
+    bool lookup(const std::string& kernel, long b, const Space& space, Config& out) {
+        std::lock_guard<std::mutex> lock(mut);
+        auto it = entries.find({kernel, b});
+        if (it == entries.end())
+            return false;
+        for (const Param& p : space)
+        {
+            auto v = it->second.config.find(p.name);
+            if (v == it->second.config.end() || std::find(p.values.begin(), p.values.end(), v->second) == p.values.end())
+                return false;
+        }
+        out = it->second.config;
+        return true;
+    }
+
+    // Stores the entry and rewrites the file (through a temporary and rename).
+    bool store(const std::string& kernel, long b, const Config& c, double seconds) {
+        std::lock_guard<std::mutex> lock(mut);
+        entries[{kernel, b}] = {seconds, c};
+        for (size_t k = path.find('/', 1); k != std::string::npos; k = path.find('/', k + 1))
+            mkdir(path.substr(0, k).c_str(), 0755);
+        std::string tmp = path + ".tmp";
+        {
+            std::ofstream out(tmp);
+            out << "# kernel bucket seconds param=value ..." << std::endl;
+            for (const auto& e : entries)
+                out << e.first.first << ' ' << e.first.second << ' ' << e.second.seconds << ' '
+                    << format(e.second.config) << std::endl;
+            if (!out)
+            {
+                std::cerr << "autotune: unable to write " << tmp << std::endl;
+                return false;
+            }
+        }
+        return std::rename(tmp.c_str(), path.c_str()) == 0;
+    }
+
+    const std::string& file() const {
+        return path;
+    }
+};
+
+// The configuration to use for `kernel` at problem size `size`; in tune
+// mode `run(config)` is timed for every candidate. run must be short and
+// leave no state the real run depends on.
+template <class F>
+Config select(const std::string& kernel, size_t size, const Space& space, F run, int reps = 2) {
+    Mode m = mode();
+    if (m == Mode::Off)
+        return defaults(space);
+    long b = bucket(size);
+    Profile& profile = Profile::machine();
+    Config c;
+    if (m == Mode::Use)
+        return profile.lookup(kernel, b, space, c) ? c : defaults(space);
+
+    double best = 1e300;
+    std::streamsize precision = std::cerr.precision();
+    for (const Config& cand : candidates(space))
+    {
+        run(cand);
+        double t = 1e300;
+        for (int r = 0; r < reps; r++)
+        {
+            auto start = std::chrono::steady_clock::now();
+            run(cand);
+            t = std::min(t, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+        }
+        std::cerr << "autotune: " << kernel << " @" << b << "  " << format(cand) << "  " << std::setprecision(4)
+                  << t * 1e3 << " ms" << std::setprecision(precision) << std::endl;
+        if (t < best)
+        {
+            best = t;
+            c = cand;
+        }
+    }
+    std::cerr << "autotune: " << kernel << " @" << b << " -> " << format(c) << " (" << profile.file() << ")"
+              << std::endl;
+    profile.store(kernel, b, c, best);
+    return c;
+}
+
+}
@@ -0,0 +1,59 @@
+#pragma once
+// Sums whose bits do not depend on the number of threads or on the order
+// they finish in. The index range is cut into fixed Chunk-sized pieces,
+// each piece is summed in index order, and the partial sums are combined by
+// a pairwise tree whose shape depends only on the number of pieces. Which
+// thread computes which piece does not matter, so every run and every
+// thread count gives the same result (not the serial loop's result, which
+// is one long chain). Build with -fopenmp; without it everything runs on
+// one thread and the result is still the same.
+#include <cstddef>
+#include <vector>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace detsum {
+
+constexpr size_t Chunk = 1024;
+
+// p[0] + ... + p[n - 1], split at the largest power of two below n.
+template <class T>
+T tree(const T* p, size_t n) {
+    if (n == 0)
+        return T(0);
+    if (n == 1)
+        return p[0];
+    size_t half = 1;
+    while (half * 2 < n)
+        half *= 2;
+    return tree(p, half) + tree(p + half, n - half);
+}
+
+// term(0) + ... + term(n - 1); threads <= 0 uses the OpenMP default.
+template <class T, class F>
+T sum(size_t n, F term, int threads = 0) {
+    size_t chunks = (n + Chunk - 1) / Chunk;
+    std::vector<T> partial(chunks);
+#ifdef _OPENMP
+    if (threads <= 0)
+        threads = omp_get_max_threads();
+#endif
+    #pragma omp parallel for schedule(static) num_threads(threads)
+    for (size_t c = 0; c < chunks; c++)
+    {
+        size_t e = c * Chunk + Chunk < n ? c * Chunk + Chunk : n;
+        T s = 0;
+        for (size_t i = c * Chunk; i < e; i++)
+            s += term(i);
+        partial[c] = s;
+    }
+    return tree(partial.data(), chunks);
+}
+
+template <class T>
+T sum(const T* x, size_t n, int threads = 0) {
+    return sum<T>(n, [x](size_t i) { return x[i]; }, threads);
+}
+
+}
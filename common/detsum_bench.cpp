@@ -0,0 +1,92 @@
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include "detsum.hpp"
+#include "philox.hpp"
+
+// Sums n values spread over ~12 decades, both signs, with 1..maxThreads
+// threads: the serial loop, `omp parallel for reduction(+)`, per-thread
+// partials added with `omp atomic` (the 22.c / task2.3 pattern), and
+// detsum::sum. Prints each result's bits and time, and whether a method
+// gave the same bits for every thread count.
+// usage: detsum_bench [n] [maxThreads]
+
+template <class F>
+double timed(F f) {
+    auto start = std::chrono::steady_clock::now();
+    f();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+std::string bits(double v) {
+    char buf[64];
+    std::snprintf(buf, sizeof(buf), "%a", v);
+    return buf;
+}
+
+int main(int argc, char const *argv[])
+{
+    size_t n = argc > 1 ? std::atol(argv[1]) : (size_t(1) << 25);
+    int maxThreads = argc > 2 ? std::atoi(argv[2]) : 8;
+    std::vector<double> x(n);
+    for (size_t i = 0; i < n; i++)
+        x[i] = philox::uniform(7, 0, i, -1.0, 1.0) * std::pow(10.0, philox::uniform(7, 1, i, -6.0, 6.0));
+
+    double serial = 0.0;
+    double t = timed([&]() {
+        for (size_t i = 0; i < n; i++)
+            serial += x[i];
+    });
+    std::cout << n << " values, serial loop " << bits(serial) << " in " << t << " s" << std::endl;
+    std::cout << std::left << std::setw(16) << "method" << std::right << std::setw(9) << "threads" << std::setw(26)
+              << "sum" << std::setw(10) << "ms" << std::endl;
+
+    bool ok = true;
+    for (std::string method : {"omp reduction", "omp atomic", "detsum"})
+    {
+        std::string first;
+        bool same = true;
+        for (int threads = 1; threads <= maxThreads; threads++)
+        {
+            double s = 0.0;
+            t = timed([&]() {
+                if (method == "omp reduction")
+                {
+                    #pragma omp parallel for reduction(+:s) num_threads(threads)
+                    for (size_t i = 0; i < n; i++)
+                        s += x[i];
+                }
+                else if (method == "omp atomic")
+                {
+                    #pragma omp parallel num_threads(threads)
+                    {
+                        double local = 0.0;
+                        #pragma omp for nowait
+                        for (size_t i = 0; i < n; i++)
+                            local += x[i];
+                        #pragma omp atomic
+                        s += local;
+                    }
+                }
+                else
+                    s = detsum::sum(x.data(), n, threads);
+            });
+            if (threads == 1)
+                first = bits(s);
+            same &= bits(s) == first;
+            std::cout << std::left << std::setw(16) << method << std::right << std::setw(9) << threads << std::setw(26)
+                      << bits(s) << std::setw(10) << std::fixed << std::setprecision(1) << t * 1e3 << std::endl;
+            std::cout.unsetf(std::ios::fixed);
+        }
+        std::cout << method << ": " << (same ? "same bits for every thread count" : "bits depend on the thread count")
+                  << std::endl;
+        if (method == "detsum")
+            ok = same;
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,187 @@
+#pragma once
+// Dense C = alpha * A * B + beta * C, row-major like task2/task3.1
+// (a[i * k + p], b[p * n + j], c[i * n + j]), for float and double.
+//
+// Goto/BLIS blocking: a kc x nc panel of B is packed into nr-wide slivers
+// (L3), an mc x kc block of A into mr-tall slivers (L2), and a register
+// microkernel keeps an mr x nr tile of C in vector registers while it walks
+// kc. OpenMP threads pack B together and take mc blocks of A each, with
+// their own packing buffer. Build with -O3 -march=native -fopenmp
+// -ffp-contract=fast so the tile update becomes FMAs; without -fopenmp it
+// runs on one thread.
+#include <cstddef>
+#include <cstring>
+#include <algorithm>
+#include "grid_alloc.hpp"
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace gemm {
+
+#if defined(__AVX512F__)
+constexpr size_t VectorBytes = 64;
+#elif defined(__AVX__)
+constexpr size_t VectorBytes = 32;
+#else
+constexpr size_t VectorBytes = 16;
+#endif
+
+template <class T> struct Vector;
+template <> struct Vector<double> { typedef double type __attribute__((vector_size(VectorBytes))); };
+template <> struct Vector<float> { typedef float type __attribute__((vector_size(VectorBytes))); };
+
+// Register tile: nr = two vectors wide, mr rows, 2 * mr accumulators
+// (24 of the 32 zmm registers, 12 of the 16 ymm/xmm).
+template <class T>
+struct Tile {
+    static constexpr size_t lanes = VectorBytes / sizeof(T);
+    static constexpr size_t nr = 2 * lanes;
+    static constexpr size_t mr = VectorBytes == 64 ? 12 : 6;
+};
+
+// Cache blocks; mc is rounded to a multiple of mr, nc of nr.
+struct Blocking {
+    size_t mc = 144;
+    size_t kc = 256;
+    size_t nc = 4096;
+};
+
+// A[i0.., p0..] (rows x depth) as mr-tall slivers, each depth x mr, zero padded.
+template <class T>
+void packA(const T* a, size_t lda, size_t rows, size_t depth, T* out) {
+    constexpr size_t mr = Tile<T>::mr;
+    for (size_t i = 0; i < rows; i += mr)
+    {
+        size_t h = std::min(mr, rows - i);
+        for (size_t p = 0; p < depth; p++)
+        {
+            for (size_t r = 0; r < h; r++)
+                out[r] = a[(i + r) * lda + p];
+            for (size_t r = h; r < mr; r++)
+                out[r] = 0;
+            out += mr;
+        }
+    }
+}
+
+// Sliver s of B[p0.., j0..] (depth x cols): depth x nr, zero padded.
+template <class T>
+void packB(const T* b, size_t ldb, size_t depth, size_t cols, size_t s, T* out) {
+    constexpr size_t nr = Tile<T>::nr;
+    size_t j = s * nr, w = std::min(nr, cols - j);
+    out += s * nr * depth;
+    for (size_t p = 0; p < depth; p++)
+    {
+        const T* row = b + p * ldb + j;
+        for (size_t c = 0; c < w; c++)
+            out[c] = row[c];
+        for (size_t c = w; c < nr; c++)
+            out[c] = 0;
+        out += nr;
+    }
+}
+
+// C tile (h x w, at most mr x nr) = alpha * sliverA * sliverB + beta * C.
+// beta == 0 does not read C.
+template <class T>
+void microkernel(size_t depth, const T* a, const T* b, T* c, size_t ldc, size_t h, size_t w, T alpha, T beta) {
+    typedef typename Vector<T>::type V;
+    constexpr size_t mr = Tile<T>::mr, nr = Tile<T>::nr, lanes = Tile<T>::lanes;
+    V c0[mr], c1[mr];
+    for (size_t r = 0; r < mr; r++)
+    {
+        c0[r] = V{};
+        c1[r] = V{};
+    }
+    for (size_t p = 0; p < depth; p++)
+    {
+        V b0, b1;
+        std::memcpy(&b0, b, sizeof(V));
+        std::memcpy(&b1, b + lanes, sizeof(V));
+        for (size_t r = 0; r < mr; r++)
+        {
+            c0[r] += a[r] * b0;
+            c1[r] += a[r] * b1;
+        }
+        a += mr;
+        b += nr;
+    }
+    if (h == mr && w == nr)
+    {
+        for (size_t r = 0; r < mr; r++)
+        {
+            T* row = c + r * ldc;
+            V x0 = alpha * c0[r], x1 = alpha * c1[r];
+            if (beta != T(0))
+            {
+                V y0, y1;
+                std::memcpy(&y0, row, sizeof(V));
+                std::memcpy(&y1, row + lanes, sizeof(V));
+                x0 += beta * y0;
+                x1 += beta * y1;
+            }
+            std::memcpy(row, &x0, sizeof(V));
+            std::memcpy(row + lanes, &x1, sizeof(V));
+        }
+        return;
+    }
+    // edge tile: through a buffer
+    alignas(VectorBytes) T tile[mr * nr];
+    for (size_t r = 0; r < mr; r++)
+    {
+        std::memcpy(tile + r * nr, &c0[r], sizeof(V));
+        std::memcpy(tile + r * nr + lanes, &c1[r], sizeof(V));
+    }
+    for (size_t r = 0; r < h; r++)
+        for (size_t j = 0; j < w; j++)
+            c[r * ldc + j] = alpha * tile[r * nr + j] + (beta != T(0) ? beta * c[r * ldc + j] : T(0));
+}
+
+// C (m x n) = alpha * A (m x k) * B (k x n) + beta * C
+template <class T>
+void multiply(size_t m, size_t n, size_t k, T alpha, const T* a, const T* b, T beta, T* c,
+              Blocking blk = Blocking()) {
+    constexpr size_t mr = Tile<T>::mr, nr = Tile<T>::nr;
+    if (m == 0 || n == 0)
+        return;
+    size_t mc = std::max(mr, blk.mc / mr * mr);
+    size_t nc = std::max(nr, blk.nc / nr * nr);
+    size_t kc = std::max<size_t>(1, blk.kc);
+    if (k == 0)
+    {
+        for (size_t i = 0; i < m * n; i++)
+            c[i] = beta != T(0) ? beta * c[i] : T(0);
+        return;
+    }
+    auto packedB = grid_alloc::make_array<T>(std::min(kc, k) * std::min(nc, (n + nr - 1) / nr * nr));
+    #pragma omp parallel
+    {
+        auto packedA = grid_alloc::make_array<T>(std::min(mc, (m + mr - 1) / mr * mr) * std::min(kc, k));
+        for (size_t jc = 0; jc < n; jc += nc)
+        {
+            size_t cols = std::min(nc, n - jc), slivers = (cols + nr - 1) / nr;
+            for (size_t pc = 0; pc < k; pc += kc)
+            {
+                size_t depth = std::min(kc, k - pc);
+                T betaBlock = pc == 0 ? beta : T(1);
+                #pragma omp for schedule(static)
+                for (size_t s = 0; s < slivers; s++)
+                    packB(b + pc * n + jc, n, depth, cols, s, packedB.get());
+                #pragma omp for schedule(dynamic)
+                for (size_t ic = 0; ic < m; ic += mc)
+                {
+                    size_t rows = std::min(mc, m - ic);
+                    packA(a + ic * k + pc, k, rows, depth, packedA.get());
+                    for (size_t jr = 0; jr < cols; jr += nr)
+                        for (size_t ir = 0; ir < rows; ir += mr)
+                            microkernel(depth, packedA.get() + ir * depth, packedB.get() + jr * depth,
+                                        c + (ic + ir) * n + jc + jr, n, std::min(mr, rows - ir),
+                                        std::min(nr, cols - jr), alpha, betaBlock);
+                }
+            }
+        }
+    }
+}
+
+}
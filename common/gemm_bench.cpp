@@ -0,0 +1,165 @@
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include "gemm.hpp"
+#include "panel_matvec.hpp"
+#include "autotune.hpp"
+
+// GFLOP/s of C = A B (n x n, double unless noted): one task3.1 matvec per
+// column of B (panel_matvec::multiplyRows), the plain i-p-j loop, and
+// gemm::multiply. The peak row runs independent FMA chains in registers,
+// the tile count of the microkernel, on every thread. Results are compared
+// with the matvec loop. gemm::multiply uses the mc/kc of the machine profile
+// (autotune.hpp); AUTOTUNE=tune times them at this n first.
+// usage: gemm_bench [n] [threads]
+
+template <class F>
+double timed(F f) {
+    auto start = std::chrono::steady_clock::now();
+    f();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void report(const std::string& name, double flops, double seconds, double peak, double err) {
+    std::cout << std::left << std::setw(26) << name << std::right << std::fixed << std::setprecision(3)
+              << std::setw(10) << seconds << std::setw(10) << std::setprecision(1) << flops / seconds / 1e9
+              << std::setw(9) << 100.0 * flops / seconds / 1e9 / peak << "%" << std::setw(12) << std::scientific
+              << std::setprecision(1) << err << std::defaultfloat << std::endl;
+}
+
+template <class T>
+double maxRelDiff(const std::vector<T>& x, const std::vector<double>& ref) {
+    double err = 0.0;
+    for (size_t i = 0; i < ref.size(); i++)
+        err = std::max(err, std::fabs(double(x[i]) - ref[i]) / std::max(1.0, std::fabs(ref[i])));
+    return err;
+}
+
+// 2 * mr vector FMA chains, the same register budget as the microkernel.
+template <class T>
+double peakGflops(int threads) {
+    typedef typename gemm::Vector<T>::type V;
+    constexpr size_t chains = 2 * gemm::Tile<T>::mr, iters = 50000000;
+    double flops = 0.0;
+    double seconds = timed([&]() {
+        #pragma omp parallel num_threads(threads) reduction(+:flops)
+        {
+            V acc[chains], x, y;
+            #pragma GCC unroll 32
+            for (size_t c = 0; c < chains; c++)
+                acc[c] = V{} + T(c);
+            x = V{} + T(0.999999);
+            y = V{} + T(1e-7);
+            for (size_t it = 0; it < iters; it++)
+                #pragma GCC unroll 32
+                for (size_t c = 0; c < chains; c++)
+                {
+                    acc[c] = acc[c] * x + y;
+                    __asm__ volatile("" : "+v"(acc[c]));   // keep every chain live
+                }
+            volatile T sink = 0;
+            #pragma GCC unroll 32
+            for (size_t c = 0; c < chains; c++)
+                sink = sink + acc[c][0];
+            flops += 2.0 * chains * gemm::Tile<T>::lanes * iters;
+        }
+    });
+    return flops / seconds / 1e9;
+}
+
+int main(int argc, char const *argv[])
+{
+    size_t n = argc > 1 ? std::atol(argv[1]) : 2048;
+    int threads = argc > 2 ? std::atoi(argv[2]) : 1;
+#ifdef _OPENMP
+    omp_set_num_threads(threads);
+#endif
+    std::vector<double> a(n * n), b(n * n), ref(n * n), c(n * n);
+    for (size_t i = 0; i < n * n; i++)
+    {
+        a[i] = std::sin(double(i));
+        b[i] = std::cos(double(i) * 0.5);
+    }
+    double flops = 2.0 * n * n * n;
+    double peak = peakGflops<double>(threads), peakF = peakGflops<float>(threads);
+    std::cout << n << " x " << n << ", " << threads << " threads, " << gemm::VectorBytes * 8 << "-bit vectors, tile "
+              << gemm::Tile<double>::mr << " x " << gemm::Tile<double>::nr << std::endl;
+    std::cout << std::left << std::setw(26) << "kernel" << std::right << std::setw(10) << "s" << std::setw(10)
+              << "GFLOP/s" << std::setw(10) << "of peak" << std::setw(12) << "rel. diff" << std::endl;
+    report("FMA peak, double", 1.0, 1.0 / peak / 1e9, peak, 0.0);
+
+    double t = timed([&]() {
+        std::vector<double> x(n), y(n);
+        for (size_t j = 0; j < n; j++)
+        {
+            for (size_t p = 0; p < n; p++)
+                x[p] = b[p * n + j];
+            panel_matvec::multiplyRows(a.data(), x.data(), y.data(), 0, n, n, threads);
+            for (size_t i = 0; i < n; i++)
+                ref[i * n + j] = y[i];
+        }
+    });
+    report("matvec per column", flops, t, peak, 0.0);
+
+    t = timed([&]() {
+        #pragma omp parallel for schedule(static)
+        for (size_t i = 0; i < n; i++)
+        {
+            for (size_t j = 0; j < n; j++)
+                c[i * n + j] = 0.0;
+            for (size_t p = 0; p < n; p++)
+                for (size_t j = 0; j < n; j++)
+                    c[i * n + j] += a[i * n + p] * b[p * n + j];
+        }
+    });
+    report("i-p-j loop", flops, t, peak, maxRelDiff(c, ref));
+
+    autotune::Space space = {{"mc", {144, 96, 192, 288}}, {"kc", {256, 192, 384, 512}}};
+    auto blocking = [](const autotune::Config& cfg) {
+        gemm::Blocking blk;
+        blk.mc = cfg.at("mc");
+        blk.kc = cfg.at("kc");
+        return blk;
+    };
+    gemm::Blocking blk = blocking(autotune::select("gemm/double", n, space, [&](const autotune::Config& cfg) {
+        gemm::multiply(n, n, n, 1.0, a.data(), b.data(), 0.0, c.data(), blocking(cfg));
+    }));
+    std::cout << "mc " << blk.mc << ", kc " << blk.kc << ", nc " << blk.nc << std::endl;
+    gemm::multiply(n, n, n, 1.0, a.data(), b.data(), 0.0, c.data(), blk);
+    t = timed([&]() { gemm::multiply(n, n, n, 1.0, a.data(), b.data(), 0.0, c.data(), blk); });
+    report("gemm::multiply", flops, t, peak, maxRelDiff(c, ref));
+
+    std::vector<float> af(a.begin(), a.end()), bf(b.begin(), b.end()), cf(n * n);
+    report("FMA peak, float", 1.0, 1.0 / peakF / 1e9, peakF, 0.0);
+    gemm::multiply(n, n, n, 1.0f, af.data(), bf.data(), 0.0f, cf.data());
+    t = timed([&]() { gemm::multiply(n, n, n, 1.0f, af.data(), bf.data(), 0.0f, cf.data()); });
+    report("gemm::multiply, float", flops, t, peakF, maxRelDiff(cf, ref));
+
+    // odd sizes and beta != 0 against the same loop
+    size_t m = 301, k = 173, w = 259;
+    std::vector<double> ao(m * k), bo(k * w), co(m * w, 1.0), ro(m * w);
+    for (size_t i = 0; i < ao.size(); i++)
+        ao[i] = std::sin(0.3 * i);
+    for (size_t i = 0; i < bo.size(); i++)
+        bo[i] = std::cos(0.7 * i);
+    for (size_t i = 0; i < m; i++)
+        for (size_t j = 0; j < w; j++)
+        {
+            double s = 0.0;
+            for (size_t p = 0; p < k; p++)
+                s += ao[i * k + p] * bo[p * w + j];
+            ro[i * w + j] = 2.0 * s + 0.5;
+        }
+    gemm::Blocking small;
+    small.mc = 50;
+    small.kc = 40;
+    small.nc = 70;
+    gemm::multiply(m, w, k, 2.0, ao.data(), bo.data(), 0.5, co.data(), small);
+    double errOdd = maxRelDiff(co, ro);
+    std::cout << "301 x 173 x 259, alpha 2, beta 0.5, small blocks: rel. diff " << errOdd << std::endl;
+    return errOdd < 1e-12 && maxRelDiff(c, ref) < 1e-10 ? 0 : 1;
+}
@@ -0,0 +1,243 @@
+#pragma once
+// Allocation layer for grids and solver buffers.
+//
+// * every block is 64-byte aligned;
+// * blocks of 2 MB and more come from mmap, aligned to 2 MB and either
+//   madvise(MADV_HUGEPAGE)'d (transparent huge pages, the default) or mapped
+//   with MAP_HUGETLB (explicit, falls back to THP when the pool is empty);
+//   GRID_HUGEPAGES=off|thp|explicit overrides the mode;
+// * Allocator<T> default-initialises, so std::vector<T, Allocator<T>>(n)
+//   does not zero the grid: the init routine is the first touch and can run
+//   in parallel (firstTouch) so pages land next to the threads using them;
+// * freed large blocks are kept in a process-wide pool (GRID_POOL_MB, 4096
+//   by default) and handed out again for the same size, so repeated solves
+//   neither page-fault nor zero their buffers again.
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <utility>
+#include <thread>
+#include <vector>
+#include <algorithm>
+#include <sys/mman.h>
+
+namespace grid_alloc {
+
+constexpr size_t Alignment = 64;
+constexpr size_t HugePage = size_t(2) << 20;
+
+enum class HugePages { Off, Transparent, Explicit };
+
+inline HugePages& hugePages() {
+    static HugePages mode = []() {
+        const char* env = std::getenv("GRID_HUGEPAGES");
+        if (env && std::strcmp(env, "off") == 0)
+            return HugePages::Off;
+        if (env && std::strcmp(env, "explicit") == 0)
+            return HugePages::Explicit;
+        return HugePages::Transparent;
+    }();
+    return mode;
+}
+
+class Pool {
+private:
+    std::mutex mut;
+    std::multimap<size_t, void*> blocks;
+    size_t cached = 0;
+    size_t limit;
+
+    Pool() {
+        const char* env = std::getenv("GRID_POOL_MB");
+        limit = (env ? std::strtoull(env, nullptr, 10) : 4096) << 20;
+    }
+
+    static void* mapBlock(size_t bytes) {
+        if (hugePages() == HugePages::Explicit)
+        {
+            void* p = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+            if (p != MAP_FAILED)
+                return p;
+        }
+        // over-map by one huge page and trim, so the block starts on a 2 MB boundary
+        size_t span = bytes + HugePage;
+        char* raw = static_cast<char*>(mmap(nullptr, span, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+        if (raw == MAP_FAILED)
+            return nullptr;
+        char* p = reinterpret_cast<char*>((reinterpret_cast<uintptr_t>(raw) + HugePage - 1) & ~(HugePage - 1));
+        if (p > raw)
+            munmap(raw, p - raw);
+        if (raw + span > p + bytes)
+            munmap(p + bytes, raw + span - (p + bytes));
+        if (hugePages() != HugePages::Off)
+            madvise(p, bytes, MADV_HUGEPAGE);
+        return p;
+    }
+
+public:
+    // atomic so they can be read without the pool's lock
+    std::atomic<size_t> hits{0};
+    std::atomic<size_t> misses{0};
+
+    static Pool& instance() {
+        static Pool pool;
+        return pool;
+    }
+
+    // bytes must be a multiple of HugePage
+    void* acquire(size_t bytes) {
+        {
+            std::lock_guard<std::mutex> lock(mut);
+            auto it = blocks.find(bytes);
+            if (it != blocks.end())
+            {
+                void* p = it->second;
+                blocks.erase(it);
+                cached -= bytes;
+                hits++;
+                return p;
+            }
+            misses++;
+        }
+        return mapBlock(bytes);
+    }
+
+    void release(void* p, size_t bytes) {
+        {
+            std::lock_guard<std::mutex> lock(mut);
+            if (cached + bytes <= limit)
+            {
+                blocks.emplace(bytes, p);
+                cached += bytes;
+                return;
+            }
+        }
+        munmap(p, bytes);
+    }
+
+    // Returns every cached block to the system.
+    void trim() {
+        std::lock_guard<std::mutex> lock(mut);
+        for (auto& b : blocks)
+            munmap(b.second, b.first);
+        blocks.clear();
+        cached = 0;
+    }
+};
+
+inline size_t roundUp(size_t bytes, size_t to) {
+    return (bytes + to - 1) / to * to;
+}
+
+inline void* allocate(size_t bytes) {
+    void* p;
+    if (bytes >= HugePage)
+        p = Pool::instance().acquire(roundUp(bytes, HugePage));
+    else
+        p = std::aligned_alloc(Alignment, roundUp(std::max<size_t>(bytes, 1), Alignment));
+    if (!p)
+        throw std::bad_alloc();
+    return p;
+}
+
+inline void deallocate(void* p, size_t bytes) {
+    if (!p)
+        return;
+    if (bytes >= HugePage)
+        Pool::instance().release(p, roundUp(bytes, HugePage));
+    else
+        std::free(p);
+}
+
+template <class T>
+class Allocator {
+public:
+    using value_type = T;
+
+    Allocator() = default;
+    template <class U>
+    Allocator(const Allocator<U>&) {}
+
+    T* allocate(size_t n) {
+        return static_cast<T*>(grid_alloc::allocate(n * sizeof(T)));
+    }
+
+    void deallocate(T* p, size_t n) {
+        grid_alloc::deallocate(p, n * sizeof(T));
+    }
+
+    // vector(n) and resize(n) leave the values uninitialised instead of zeroing
+    template <class U>
+    void construct(U* p) {
+        ::new (static_cast<void*>(p)) U;
+    }
+
+    template <class U, class... Args>
+    void construct(U* p, Args&&... args) {
+        ::new (static_cast<void*>(p)) U(std::forward<Args>(args)...);
+    }
+
+    template <class U>
+    bool operator==(const Allocator<U>&) const { return true; }
+    template <class U>
+    bool operator!=(const Allocator<U>&) const { return false; }
+};
+
+template <class T>
+using vector = std::vector<T, Allocator<T>>;
+
+template <class T>
+struct ArrayDeleter {
+    size_t n;
+    void operator()(T* p) const {
+        deallocate(p, n * sizeof(T));
+    }
+};
+
+// Drop-in for std::unique_ptr<T[]>(new T[n]) with the same uninitialised contents.
+template <class T>
+using unique_array = std::unique_ptr<T[], ArrayDeleter<T>>;
+
+template <class T>
+unique_array<T> make_array(size_t n) {
+    return unique_array<T>(static_cast<T*>(allocate(n * sizeof(T))), ArrayDeleter<T>{n});
+}
+
+// Runs fn(begin, end) over [0, n) split into contiguous, page-aligned slices,
+// one per thread, so each page is first touched by the thread whose part of
+// the grid it holds.
+template <class T, class F>
+void firstTouch(size_t n, F fn, int threads = 0) {
+    if (threads <= 0)
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    size_t perPage = std::max<size_t>(1, 4096 / sizeof(T));
+    size_t slice = roundUp((n + threads - 1) / threads, perPage);
+    if (threads == 1 || n <= perPage)
+    {
+        fn(size_t(0), n);
+        return;
+    }
+    std::vector<std::thread> pool;
+    for (int t = 0; t < threads; t++)
+    {
+        size_t b = std::min(n, t * slice);
+        size_t e = std::min(n, b + slice);
+        if (b < e)
+            pool.emplace_back([=]() { fn(b, e); });
+    }
+    for (auto& th : pool)
+        th.join();
+}
+
+template <class T>
+void parallelFill(T* p, size_t n, T value, int threads = 0) {
+    firstTouch<T>(n, [=](size_t b, size_t e) { std::fill(p + b, p + e, value); }, threads);
+}
+
+}
@@ -0,0 +1,550 @@
+#pragma once
+// Binary grid files: a fixed 64-byte header followed by the raw row-major
+// payload (or, with GRID_COMPRESSED, a table of zlib-compressed chunks).
+//
+//   offset  size  field
+//   0       4     magic "GRD1"
+//   4       4     dtype: 4 = float, 8 = double
+//   8       4     flags: bit 0 = compressed, bit 1 = bytes shuffled
+//   12      4     chunk size in elements (compressed files only)
+//   16      8     rows
+//   24      8     cols
+//   32      8     depth (1 for 2D grids)
+//   40      8     payload size in bytes as stored on disk
+//   48      16    reserved, zero
+//
+// A compressed payload starts with uint64 chunk count, then one uint64
+// compressed size per chunk, then the chunks back to back. Chunks are
+// compressed and decompressed in parallel. Before compression each chunk is
+// byte-shuffled (all first bytes of the values, then all second bytes, ...):
+// exponents and high mantissa bytes of a smooth field then form long runs
+// that deflate handles far better than interleaved doubles.
+#include <cstdint>
+#include <cstring>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <thread>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <zlib.h>
+
+namespace grid_io {
+
+constexpr uint32_t GRID_COMPRESSED = 1;
+constexpr uint32_t GRID_SHUFFLED = 2;
+
+struct Header {
+    char magic[4] = {'G', 'R', 'D', '1'};
+    uint32_t dtype = 8;
+    uint32_t flags = 0;
+    uint32_t chunk = 0;
+    uint64_t rows = 0;
+    uint64_t cols = 0;
+    uint64_t depth = 1;
+    uint64_t payload = 0;
+    uint64_t reserved[2] = {0, 0};
+};
+static_assert(sizeof(Header) == 64, "grid header must stay 64 bytes");
+
+// rows * cols * depth == n, checked without overflowing; a grid with no
+// columns or planes never matches
+inline bool hasElements(const Header& h, uint64_t n) {
+    return h.cols != 0 && h.depth != 0 && n % h.depth == 0 && n / h.depth % h.cols == 0 &&
+           n / h.depth / h.cols == h.rows;
+}
+
+struct WriteOptions {
+    int threads = 1;          // threads copying / compressing the payload
+    bool useMmap = true;      // mmap the output file, otherwise pwrite large blocks
+    int compress = 0;         // zlib level 1..9, 0 = raw payload
+    size_t chunkElems = 1 << 20;
+};
+
+template <class T>
+struct Grid {
+    uint64_t rows = 0, cols = 0, depth = 1;
+    std::vector<T> data;
+};
+
+template <class F>
+inline void parallelFor(size_t count, int threads, F&& body) {
+    threads = std::max(1, std::min<int>(threads, count));
+    if (threads == 1)
+    {
+        for (size_t k = 0; k < count; k++)
+            body(k);
+        return;
+    }
+    std::vector<std::thread> pool;
+    for (int t = 0; t < threads; t++)
+        pool.emplace_back([&, t]() {
+            for (size_t k = t; k < count; k += threads)
+                body(k);
+        });
+    for (auto& th : pool)
+        th.join();
+}
+
+inline void shuffleBytes(const unsigned char* src, unsigned char* dst, size_t count, size_t width) {
+    for (size_t b = 0; b < width; b++)
+        for (size_t k = 0; k < count; k++)
+            dst[b * count + k] = src[k * width + b];
+}
+
+inline void unshuffleBytes(const unsigned char* src, unsigned char* dst, size_t count, size_t width) {
+    for (size_t b = 0; b < width; b++)
+        for (size_t k = 0; k < count; k++)
+            dst[k * width + b] = src[b * count + k];
+}
+
+inline bool writeAll(int fd, const void* buf, size_t len, off_t off) {
+    const char* p = static_cast<const char*>(buf);
+    while (len > 0)
+    {
+        ssize_t w = pwrite(fd, p, std::min<size_t>(len, 1 << 30), off);
+        if (w <= 0)
+            return false;
+        p += w;
+        off += w;
+        len -= w;
+    }
+    return true;
+}
+
+// Writes bytes at the start of the file, either through a shared mapping or
+// with pwrite in `threads` contiguous slices.
+inline bool writeBlocks(const std::string& filename, const std::vector<std::pair<const void*, size_t>>& parts,
+                        const WriteOptions& opt) {
+    size_t total = 0;
+    for (const auto& p : parts)
+        total += p.second;
+    int fd = open(filename.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+    {
+        std::cerr << "Unable to open file " << filename << " for writing." << std::endl;
+        return false;
+    }
+    bool ok = ftruncate(fd, total) == 0;
+    char* map = nullptr;
+    if (ok && opt.useMmap)
+    {
+        void* m = mmap(nullptr, total, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (m != MAP_FAILED)
+            map = static_cast<char*>(m);
+    }
+    size_t off = 0;
+    for (const auto& p : parts)
+    {
+        if (!ok)
+            break;
+        size_t slices = std::max<size_t>(1, std::min<size_t>(opt.threads, p.second >> 20));
+        size_t step = (p.second + slices - 1) / slices;
+        std::vector<char> sliceOk(slices, 1);
+        parallelFor(slices, opt.threads, [&](size_t k) {
+            size_t b = k * step;
+            size_t e = std::min(p.second, b + step);
+            if (b >= e)
+                return;
+            const char* src = static_cast<const char*>(p.first) + b;
+            if (map)
+                std::memcpy(map + off + b, src, e - b);
+            else
+                sliceOk[k] = writeAll(fd, src, e - b, off + b);
+        });
+        ok = std::all_of(sliceOk.begin(), sliceOk.end(), [](char c) { return c != 0; });
+        off += p.second;
+    }
+    if (map)
+        munmap(map, total);
+    close(fd);
+    if (!ok)
+        std::cerr << "Unable to write " << filename << std::endl;
+    return ok;
+}
+
+template <class T>
+bool writeGrid(const std::string& filename, const T* data, uint64_t rows, uint64_t cols, uint64_t depth = 1,
+               const WriteOptions& opt = {}) {
+    static_assert(sizeof(T) == 4 || sizeof(T) == 8, "float or double grids only");
+    Header h;
+    h.dtype = sizeof(T);
+    h.rows = rows;
+    h.cols = cols;
+    h.depth = depth;
+    size_t bytes = rows * cols * depth * sizeof(T);
+    if (opt.compress <= 0)
+    {
+        h.payload = bytes;
+        return writeBlocks(filename, {{&h, sizeof(h)}, {data, bytes}}, opt);
+    }
+
+    size_t chunkBytes = opt.chunkElems * sizeof(T);
+    size_t chunks = (bytes + chunkBytes - 1) / chunkBytes;
+    std::vector<std::vector<unsigned char>> packed(chunks);
+    std::vector<uint64_t> table(chunks + 1);
+    table[0] = chunks;
+    std::vector<char> chunkOk(chunks, 1);
+    parallelFor(chunks, opt.threads, [&](size_t k) {
+        const Bytef* src = reinterpret_cast<const Bytef*>(data) + k * chunkBytes;
+        uLong len = std::min(chunkBytes, bytes - k * chunkBytes);
+        std::vector<unsigned char> shuffled(len);
+        shuffleBytes(src, shuffled.data(), len / sizeof(T), sizeof(T));
+        uLongf out = compressBound(len);
+        packed[k].resize(out);
+        chunkOk[k] = compress2(packed[k].data(), &out, shuffled.data(), len, opt.compress) == Z_OK;
+        packed[k].resize(out);
+        table[k + 1] = out;
+    });
+    if (!std::all_of(chunkOk.begin(), chunkOk.end(), [](char c) { return c != 0; }))
+    {
+        std::cerr << "Unable to compress " << filename << std::endl;
+        return false;
+    }
+    h.flags |= GRID_COMPRESSED | GRID_SHUFFLED;
+    h.chunk = opt.chunkElems;
+    h.payload = table.size() * sizeof(uint64_t);
+    std::vector<std::pair<const void*, size_t>> parts = {{&h, sizeof(h)}, {table.data(), table.size() * sizeof(uint64_t)}};
+    for (const auto& c : packed)
+    {
+        parts.push_back({c.data(), c.size()});
+        h.payload += c.size();
+    }
+    return writeBlocks(filename, parts, opt);
+}
+
+inline bool isGridFile(const std::string& filename) {
+    std::ifstream in(filename, std::ios::binary);
+    char magic[4] = {};
+    in.read(magic, 4);
+    return in && std::memcmp(magic, Header().magic, 4) == 0;
+}
+
+// Reads a binary grid through mmap, converting float/double to T.
+template <class T>
+bool readGrid(const std::string& filename, Grid<T>& grid, int threads = 1) {
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        std::cerr << "Unable to open file " << filename << std::endl;
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || size_t(st.st_size) < sizeof(Header))
+    {
+        close(fd);
+        std::cerr << filename << " is not a grid file" << std::endl;
+        return false;
+    }
+    size_t size = st.st_size;
+    void* m = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (m == MAP_FAILED)
+        return false;
+    const char* base = static_cast<const char*>(m);
+    Header h;
+    std::memcpy(&h, base, sizeof(h));
+    if (std::memcmp(h.magic, Header().magic, 4) != 0 || (h.dtype != 4 && h.dtype != 8) ||
+        h.payload > size - sizeof(Header))
+    {
+        munmap(m, size);
+        std::cerr << filename << " is not a grid file" << std::endl;
+        return false;
+    }
+    size_t count = h.rows * h.cols * h.depth;
+    size_t bytes = count * h.dtype;
+    const char* payload = base + sizeof(Header);
+    const uint64_t* table = reinterpret_cast<const uint64_t*>(payload);
+    size_t chunkBytes = size_t(h.chunk) * h.dtype;
+    size_t chunks = 0;
+    std::vector<size_t> offsets;
+    // the dimensions must fit in size_t, and every read below stays inside
+    // the payload: a raw one holds exactly the values, a compressed one the
+    // table, the chunks the table points at, and as many chunks as the
+    // dimensions need
+    bool valid = hasElements(h, count) && count <= SIZE_MAX / h.dtype;
+    if (valid && !(h.flags & GRID_COMPRESSED))
+        valid = h.payload == bytes;
+    else if (valid)
+    {
+        valid = h.chunk > 0 && h.payload >= sizeof(uint64_t);
+        chunks = valid ? table[0] : 0;
+        valid = valid && chunks <= h.payload / sizeof(uint64_t) - 1 && chunks == (bytes + chunkBytes - 1) / chunkBytes;
+        if (valid)
+        {
+            offsets.assign(chunks + 1, (chunks + 1) * sizeof(uint64_t));
+            for (size_t k = 0; valid && k < chunks; k++)
+            {
+                valid = table[k + 1] <= h.payload - offsets[k];
+                offsets[k + 1] = offsets[k] + table[k + 1];
+            }
+        }
+    }
+    if (!valid)
+    {
+        munmap(m, size);
+        std::cerr << filename << ": header does not match the payload" << std::endl;
+        return false;
+    }
+    grid.rows = h.rows;
+    grid.cols = h.cols;
+    grid.depth = h.depth;
+    std::vector<char> raw;
+    bool ok = true;
+    if (h.flags & GRID_COMPRESSED)
+    {
+        raw.resize(bytes);
+        std::vector<char> chunkOk(chunks, 1);
+        parallelFor(chunks, threads, [&](size_t k) {
+            uLongf len = std::min(chunkBytes, bytes - k * chunkBytes);
+            uLongf out = len;
+            unsigned char* dst = reinterpret_cast<unsigned char*>(raw.data() + k * chunkBytes);
+            std::vector<unsigned char> shuffled((h.flags & GRID_SHUFFLED) ? len : 0);
+            chunkOk[k] = uncompress(shuffled.empty() ? dst : shuffled.data(), &out,
+                                    reinterpret_cast<const Bytef*>(payload + offsets[k]), table[k + 1]) == Z_OK && out == len;
+            if (chunkOk[k] && !shuffled.empty())
+                unshuffleBytes(shuffled.data(), dst, len / h.dtype, h.dtype);
+        });
+        ok = std::all_of(chunkOk.begin(), chunkOk.end(), [](char c) { return c != 0; });
+        payload = raw.data();
+    }
+    grid.data.resize(count);
+    if (ok && h.dtype == sizeof(T))
+        std::memcpy(grid.data.data(), payload, bytes);
+    else if (ok && h.dtype == 4)
+        std::copy_n(reinterpret_cast<const float*>(payload), count, grid.data.begin());
+    else if (ok)
+        std::copy_n(reinterpret_cast<const double*>(payload), count, grid.data.begin());
+    munmap(m, size);
+    if (!ok)
+        std::cerr << "Corrupted payload in " << filename << std::endl;
+    return ok;
+}
+
+// An uncompressed grid file of T mapped in place, for data larger than
+// memory: nothing is copied, pages are read on first access. `open` maps an
+// existing file read-only, `create` sizes a new one and maps it writable so
+// it can be filled a block at a time. willNeed/drop pass hints for a range
+// of elements to the kernel: start reading it ahead / drop it from this
+// mapping and the page cache once it has been used.
+template <class T>
+class MappedGrid {
+private:
+    int fd = -1;
+    char* base = nullptr;
+    size_t size = 0;
+    bool writable = false;
+
+    bool map(const std::string& filename, int prot) {
+        void* m = mmap(nullptr, size, prot, MAP_SHARED, fd, 0);
+        if (m == MAP_FAILED)
+        {
+            std::cerr << "Unable to map " << filename << std::endl;
+            close();
+            return false;
+        }
+        base = static_cast<char*>(m);
+        return true;
+    }
+
+    // [first, first + count) elements as whole pages of the file
+    std::pair<size_t, size_t> pages(size_t first, size_t count) const {
+        size_t page = sysconf(_SC_PAGESIZE);
+        size_t b = sizeof(Header) + std::min(first, elements()) * sizeof(T);
+        size_t e = sizeof(Header) + std::min(first + count, elements()) * sizeof(T);
+        b = b / page * page;
+        return {b, e > b ? e - b : 0};
+    }
+
+public:
+    uint64_t rows = 0, cols = 0, depth = 1;
+
+    MappedGrid() = default;
+    MappedGrid(const MappedGrid&) = delete;
+    MappedGrid& operator=(const MappedGrid&) = delete;
+    ~MappedGrid() {
+        close();
+    }
+
+    bool open(const std::string& filename) {
+        close();
+        fd = ::open(filename.c_str(), O_RDONLY);
+        if (fd < 0)
+        {
+            std::cerr << "Unable to open file " << filename << std::endl;
+            return false;
+        }
+        struct stat st;
+        if (fstat(fd, &st) != 0)
+        {
+            std::cerr << "Unable to stat " << filename << std::endl;
+            close();
+            return false;
+        }
+        size = st.st_size;
+        Header h;
+        if (size < sizeof(Header) || pread(fd, &h, sizeof(h), 0) != ssize_t(sizeof(h)) ||
+            std::memcmp(h.magic, Header().magic, 4) != 0 || h.payload > size - sizeof(Header))
+        {
+            std::cerr << filename << " is not a grid file" << std::endl;
+            close();
+            return false;
+        }
+        if ((h.flags & GRID_COMPRESSED) || h.dtype != sizeof(T))
+        {
+            std::cerr << filename << ": only uncompressed grids of " << sizeof(T) << "-byte values can be mapped" << std::endl;
+            close();
+            return false;
+        }
+        // every element the dimensions promise must be inside the payload
+        if (h.payload % sizeof(T) != 0 || !hasElements(h, h.payload / sizeof(T)))
+        {
+            std::cerr << filename << ": " << h.rows << 'x' << h.cols << 'x' << h.depth
+                      << " does not match a payload of " << h.payload << " bytes" << std::endl;
+            close();
+            return false;
+        }
+        rows = h.rows;
+        cols = h.cols;
+        depth = h.depth;
+        writable = false;
+        return map(filename, PROT_READ);
+    }
+
+    bool create(const std::string& filename, uint64_t rows, uint64_t cols, uint64_t depth = 1) {
+        static_assert(sizeof(T) == 4 || sizeof(T) == 8, "float or double grids only");
+        close();
+        Header h;
+        h.dtype = sizeof(T);
+        h.rows = rows;
+        h.cols = cols;
+        h.depth = depth;
+        h.payload = rows * cols * depth * sizeof(T);
+        size = sizeof(Header) + h.payload;
+        fd = ::open(filename.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0 || ftruncate(fd, size) != 0 || !writeAll(fd, &h, sizeof(h), 0))
+        {
+            std::cerr << "Unable to create " << filename << std::endl;
+            close();
+            return false;
+        }
+        this->rows = rows;
+        this->cols = cols;
+        this->depth = depth;
+        writable = true;
+        return map(filename, PROT_READ | PROT_WRITE);
+    }
+
+    void close() {
+        if (base)
+            munmap(base, size);
+        if (fd >= 0)
+            ::close(fd);
+        base = nullptr;
+        fd = -1;
+    }
+
+    bool isOpen() const {
+        return base != nullptr;
+    }
+    size_t elements() const {
+        return rows * cols * depth;
+    }
+    const T* data() const {
+        return reinterpret_cast<const T*>(base + sizeof(Header));
+    }
+    T* data() {
+        return reinterpret_cast<T*>(base + sizeof(Header));
+    }
+
+    void willNeed(size_t first, size_t count) const {
+        auto r = pages(first, count);
+        if (r.second)
+            madvise(base + r.first, r.second, MADV_WILLNEED);
+    }
+
+    // Written pages are flushed first. Only pages wholly inside the range
+    // leave the page cache, so neighbouring panels are not affected.
+    void drop(size_t first, size_t count) const {
+        auto r = pages(first, count);
+        if (!r.second)
+            return;
+        if (writable)
+            msync(base + r.first, r.second, MS_SYNC);
+        madvise(base + r.first, r.second, MADV_DONTNEED);
+        size_t page = sysconf(_SC_PAGESIZE);
+        size_t b = (sizeof(Header) + first * sizeof(T) + page - 1) / page * page;
+        size_t e = r.first + r.second;
+        if (e > b)
+            posix_fadvise(fd, b, e - b, POSIX_FADV_DONTNEED);
+    }
+
+    // Evicts the whole file from the page cache, for cold-read measurements.
+    void dropAll() const {
+        drop(0, elements());
+        posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    }
+};
+
+// The old saveMatrixToFile/savematrix text layout: setw(10), fixed, 4 digits.
+template <class T>
+bool writeGridText(const std::string& filename, const T* data, uint64_t rows, uint64_t cols) {
+    std::ofstream outputFile(filename);
+    if (!outputFile.is_open()) {
+        std::cerr << "Unable to open file " << filename << " for writing." << std::endl;
+        return false;
+    }
+    for (uint64_t i = 0; i < rows; ++i) {
+        for (uint64_t j = 0; j < cols; ++j) {
+            outputFile << std::setw(10) << std::fixed << std::setprecision(4) << data[i * cols + j];
+        }
+        outputFile << std::endl;
+    }
+    return true;
+}
+
+// Parses the text layout back: one row per line, whitespace separated.
+template <class T>
+bool readGridText(const std::string& filename, Grid<T>& grid) {
+    std::ifstream in(filename);
+    if (!in.is_open())
+    {
+        std::cerr << "Unable to open file " << filename << std::endl;
+        return false;
+    }
+    grid.data.clear();
+    grid.rows = 0;
+    grid.cols = 0;
+    grid.depth = 1;
+    std::string line;
+    while (std::getline(in, line))
+    {
+        const char* p = line.c_str();
+        char* end;
+        uint64_t cols = 0;
+        for (double v = std::strtod(p, &end); end != p; v = std::strtod(p, &end))
+        {
+            grid.data.push_back(v);
+            p = end;
+            cols++;
+        }
+        if (cols == 0)
+            continue;
+        if (grid.rows > 0 && cols != grid.cols)
+        {
+            std::cerr << filename << ": row " << grid.rows << " has " << cols << " values, expected " << grid.cols << std::endl;
+            return false;
+        }
+        grid.cols = cols;
+        grid.rows++;
+    }
+    return true;
+}
+
+}
@@ -0,0 +1,72 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <cmath>
+#include <memory>
+#include <functional>
+#include <thread>
+#include "grid_io.hpp"
+
+// Write time of the old setw/setprecision text output against the binary
+// writers on an N x N smooth field. usage: grid_io_bench [N] [threads]
+double cpuSecond()
+{
+    auto now = std::chrono::system_clock::now();
+    auto duration = now.time_since_epoch();
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count() * 1e-9;
+}
+
+void saveMatrixToFile(const double* matrix, int N, const std::string& filename) {
+    std::ofstream outputFile(filename);
+    int fieldWidth = 10;
+    for (int i = 0; i < N; ++i) {
+        for (int j = 0; j < N; ++j) {
+            outputFile << std::setw(fieldWidth) << std::fixed << std::setprecision(4) << matrix[i * N + j];
+        }
+        outputFile << std::endl;
+    }
+}
+
+int main(int argc, char const *argv[])
+{
+    int N = argc > 1 ? std::atoi(argv[1]) : 2048;
+    int threads = argc > 2 ? std::atoi(argv[2]) : std::thread::hardware_concurrency();
+    std::unique_ptr<double[]> m(new double[size_t(N) * N]);
+    for (int i = 0; i < N; i++)
+        for (int j = 0; j < N; j++)
+            m[size_t(i) * N + j] = 10.0 + 20.0 * std::sin(0.01 * i) * std::cos(0.013 * j);
+    double mb = double(N) * N * sizeof(double) / (1 << 20);
+
+    auto bench = [&](const char* name, const char* file, std::function<void()> fn) {
+        double t = cpuSecond();
+        fn();
+        t = cpuSecond() - t;
+        struct stat st;
+        stat(file, &st);
+        std::cout << std::setw(28) << std::left << name << std::right << std::fixed << std::setprecision(3)
+                  << std::setw(10) << t << " s" << std::setw(10) << std::setprecision(1) << mb / t << " MB/s"
+                  << std::setw(12) << st.st_size / (1 << 20) << " MB on disk" << std::endl;
+        return t;
+    };
+
+    std::cout << "N = " << N << ", " << mb << " MB of doubles, " << threads << " threads" << std::endl;
+    double text = bench("text (saveMatrixToFile)", "bench_text.txt", [&]() { saveMatrixToFile(m.get(), N, "bench_text.txt"); });
+    grid_io::WriteOptions opt;
+    opt.useMmap = false;
+    double raw = bench("binary pwrite", "bench_raw.grid", [&]() { grid_io::writeGrid("bench_raw.grid", m.get(), N, N, 1, opt); });
+    opt.useMmap = true;
+    bench("binary mmap", "bench_mmap.grid", [&]() { grid_io::writeGrid("bench_mmap.grid", m.get(), N, N, 1, opt); });
+    opt.threads = threads;
+    bench("binary mmap, parallel", "bench_par.grid", [&]() { grid_io::writeGrid("bench_par.grid", m.get(), N, N, 1, opt); });
+    opt.compress = 1;
+    bench("zlib level 1, parallel", "bench_z.grid", [&]() { grid_io::writeGrid("bench_z.grid", m.get(), N, N, 1, opt); });
+    std::cout << "binary speedup over text: " << std::setprecision(1) << text / raw << "x" << std::endl;
+
+    grid_io::Grid<double> back;
+    grid_io::readGrid("bench_z.grid", back, threads);
+    bool same = back.data.size() == size_t(N) * N && std::memcmp(back.data.data(), m.get(), back.data.size() * sizeof(double)) == 0;
+    std::cout << "compressed round trip " << (same ? "exact" : "MISMATCH") << std::endl;
+    for (const char* f : {"bench_text.txt", "bench_raw.grid", "bench_mmap.grid", "bench_par.grid", "bench_z.grid"})
+        std::remove(f);
+    return same ? 0 : 1;
+}
@@ -0,0 +1,67 @@
+#include <iostream>
+#include <string>
+#include <cstring>
+#include "grid_io.hpp"
+
+// Converts between the old text matrix files (Out_Matr.txt, matrix.txt,
+// cuda.txt) and binary .grid files, in either direction.
+//   gridconv in.txt out.grid [--float] [--compress level] [--threads n]
+//   gridconv in.grid out.txt
+//   gridconv --info file.grid
+int main(int argc, char const *argv[])
+{
+    if (argc < 3)
+    {
+        std::cout << "usage: gridconv in out [--float] [--compress level] [--threads n]\n"
+                     "       gridconv --info file.grid" << std::endl;
+        return 1;
+    }
+    grid_io::Grid<double> grid;
+    if (std::strcmp(argv[1], "--info") == 0)
+    {
+        grid_io::Header h;
+        std::ifstream in(argv[2], std::ios::binary);
+        in.read(reinterpret_cast<char*>(&h), sizeof(h));
+        if (!in || !grid_io::isGridFile(argv[2]))
+        {
+            std::cerr << argv[2] << " is not a grid file" << std::endl;
+            return 1;
+        }
+        std::cout << "rows: " << h.rows << " cols: " << h.cols << " depth: " << h.depth
+                  << " dtype: " << (h.dtype == 4 ? "float" : "double")
+                  << " compressed: " << ((h.flags & grid_io::GRID_COMPRESSED) ? "yes" : "no")
+                  << " payload: " << h.payload << " bytes" << std::endl;
+        return 0;
+    }
+    std::string input = argv[1];
+    std::string output = argv[2];
+    bool asFloat = false;
+    grid_io::WriteOptions opt;
+    for (int k = 3; k < argc; k++)
+    {
+        if (std::strcmp(argv[k], "--float") == 0)
+            asFloat = true;
+        else if (std::strcmp(argv[k], "--compress") == 0 && k + 1 < argc)
+            opt.compress = std::atoi(argv[++k]);
+        else if (std::strcmp(argv[k], "--threads") == 0 && k + 1 < argc)
+            opt.threads = std::atoi(argv[++k]);
+    }
+
+    bool binaryIn = grid_io::isGridFile(input);
+    bool ok = binaryIn ? grid_io::readGrid(input, grid, opt.threads) : grid_io::readGridText(input, grid);
+    if (!ok)
+        return 1;
+    uint64_t rows = grid.rows * grid.depth;
+    if (binaryIn)
+        ok = grid_io::writeGridText(output, grid.data.data(), rows, grid.cols);
+    else if (asFloat)
+    {
+        std::vector<float> f(grid.data.begin(), grid.data.end());
+        ok = grid_io::writeGrid(output, f.data(), grid.rows, grid.cols, 1, opt);
+    }
+    else
+        ok = grid_io::writeGrid(output, grid.data.data(), grid.rows, grid.cols, 1, opt);
+    if (ok)
+        std::cout << input << " -> " << output << " (" << grid.rows << " x " << grid.cols << ")" << std::endl;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,111 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+#include "grid_io.hpp"
+
+// y = A x with A in a mapped grid file, one panel of rows at a time, so the
+// matrix may be larger than memory. While the panel p is multiplied the next
+// one is brought in:
+//   Advise  madvise(MADV_WILLNEED), the kernel starts asynchronous readahead;
+//   Thread  a helper thread reads one byte per page of panel p+1, so its page
+//           faults and the disk wait overlap the multiply;
+//   None    pages are faulted in by the multiply itself.
+// With `drop` a finished panel leaves the mapping and the page cache, so the
+// resident set stays at about two panels however large the file is.
+namespace panel_matvec {
+
+enum class Prefetch { None, Advise, Thread };
+
+struct Options {
+    size_t panelBytes = size_t(64) << 20;
+    int threads = 1;                // threads multiplying each panel
+    Prefetch prefetch = Prefetch::Thread;
+    bool drop = true;
+};
+
+struct Stats {
+    double seconds = 0.0;
+    double bytes = 0.0;             // matrix bytes streamed
+    size_t panels = 0;
+    double gbps() const {
+        return bytes / seconds / 1e9;
+    }
+};
+
+// Rows [r0, r1) of a row-major n-column matrix, the task3.1 row loop.
+template <class T>
+void multiplyRows(const T* a, const T* x, T* y, size_t r0, size_t r1, size_t n) {
+    for (size_t i = r0; i < r1; i++)
+    {
+        T sum = 0;
+        const T* row = a + i * n;
+        for (size_t j = 0; j < n; j++)
+            sum += row[j] * x[j];
+        y[i] = sum;
+    }
+}
+
+// The same over `threads` contiguous slices of rows.
+template <class T>
+void multiplyRows(const T* a, const T* x, T* y, size_t r0, size_t r1, size_t n, int threads) {
+    if (threads <= 1)
+    {
+        multiplyRows(a, x, y, r0, r1, n);
+        return;
+    }
+    std::vector<std::thread> pool;
+    size_t rows = r1 - r0;
+    for (int t = 0; t < threads; t++)
+    {
+        size_t b = r0 + rows * t / threads, e = r0 + rows * (t + 1) / threads;
+        pool.emplace_back([=]() { multiplyRows(a, x, y, b, e, n); });
+    }
+    for (auto& th : pool)
+        th.join();
+}
+
+// Faults in elements [first, first + count) one page at a time.
+template <class T>
+void touch(const T* a, size_t first, size_t count) {
+    size_t step = std::max<size_t>(1, sysconf(_SC_PAGESIZE) / sizeof(T));
+    volatile T sink = 0;
+    for (size_t k = first; k < first + count; k += step)
+        sink = a[k];
+    (void)sink;
+}
+
+template <class T>
+Stats multiply(const grid_io::MappedGrid<T>& A, const T* x, T* y, const Options& o = Options()) {
+    const size_t m = A.rows * A.depth, n = A.cols;
+    const size_t panelRows = std::max<size_t>(1, o.panelBytes / (n * sizeof(T)));
+    const T* a = A.data();
+    Stats s;
+    auto start = std::chrono::steady_clock::now();
+    if (o.prefetch == Prefetch::Advise)
+        A.willNeed(0, std::min(panelRows, m) * n);
+    for (size_t r0 = 0; r0 < m; r0 += panelRows)
+    {
+        size_t r1 = std::min(m, r0 + panelRows);
+        size_t next = r1, nextEnd = std::min(m, r1 + panelRows);
+        std::thread helper;
+        if (next < m && o.prefetch == Prefetch::Advise)
+            A.willNeed(next * n, (nextEnd - next) * n);
+        else if (next < m && o.prefetch == Prefetch::Thread)
+            helper = std::thread([=]() { touch(a, next * n, (nextEnd - next) * n); });
+        multiplyRows(a, x, y, r0, r1, n, o.threads);
+        if (helper.joinable())
+            helper.join();
+        if (o.drop)
+            A.drop(r0 * n, (r1 - r0) * n);
+        s.panels++;
+    }
+    s.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    s.bytes = double(m) * n * sizeof(T);
+    return s;
+}
+
+}
@@ -0,0 +1,422 @@
+#pragma once
+// Named timing regions with hardware counters and a roofline report.
+//
+//   static perf_regions::Region sweepRegion("jacobi sweep");
+//   {
+//       perf_regions::Scope s(sweepRegion, flops, bytes);
+//       ... kernel ...
+//   }
+//
+// Everything is off unless PERF_REGIONS is set (to anything but 0); a Scope
+// then costs one branch. PERF_REGIONS=threads also prints every thread.
+// When on, every thread that enters a Scope opens its own perf_event_open
+// counters (cycles, instructions, LLC misses, task clock), and each Region
+// keeps per-thread totals. At exit, or on report(), every region gets a line
+// with its calls, time, counters, and its place on the host's roofline:
+//   GFLOP/s = declared flops / time,   AI = declared flops / declared bytes,
+//   roof = min(peak GFLOP/s, AI * peak GB/s).
+// Region time is the largest per-thread total, so a scope opened by every
+// thread of a parallel loop and one opened around the whole loop both give
+// the wall time. The peaks are measured once (FMA chains and a triad on all
+// hardware threads) unless PERF_PEAK_GFLOPS / PERF_PEAK_GBS give them.
+// Counters the kernel or the hypervisor does not provide print as "n/a"
+// (IPC, LLC GB/s = LLC misses * 64 B / time); GB/s, AI and the roofline use
+// only the declared bytes and the clock, so they work without any.
+//
+// The counters only see the thread that opened the scope. Open one scope per
+// thread inside a parallel region; a scope around work that other threads do
+// (an OpenACC kernel, a task graph replay) passes Span::Team, and its region
+// prints IPC and LLC GB/s as "n/a".
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace perf_regions {
+
+inline bool enabled() {
+    static bool on = []() {
+        const char* env = std::getenv("PERF_REGIONS");
+        return env && *env && std::strcmp(env, "0") != 0;
+    }();
+    return on;
+}
+
+// PERF_REGIONS=threads adds a line per thread under every region.
+inline bool perThreadReport() {
+    const char* env = std::getenv("PERF_REGIONS");
+    return env && std::strcmp(env, "threads") == 0;
+}
+
+enum Event { Cycles, Instructions, LlcMisses, TaskClock, Events };
+
+// Where the work of a scope runs: on the thread that opened it, or on
+// threads (or a device) its counters do not see.
+enum class Span { Thread, Team };
+
+struct Sample {
+    uint64_t value[Events] = {};
+};
+
+// The calling thread's counters, opened on first use.
+class ThreadCounters {
+private:
+    int fd[Events];
+
+    static int open(uint32_t type, uint64_t config) {
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = type;
+        attr.config = config;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        return int(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+    }
+
+public:
+    ThreadCounters() {
+        fd[Cycles] = open(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+        fd[Instructions] = open(PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+        fd[LlcMisses] = open(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+        fd[TaskClock] = open(PERF_TYPE_SOFTWARE, PERF_COUNT_SW_TASK_CLOCK);
+    }
+    ~ThreadCounters() {
+        for (int e = 0; e < Events; e++)
+            if (fd[e] >= 0)
+                close(fd[e]);
+    }
+
+    bool available(int e) const {
+        return fd[e] >= 0;
+    }
+
+    // Scaled for multiplexing: value * enabled / running.
+    Sample read() const {
+        Sample s;
+        for (int e = 0; e < Events; e++)
+        {
+            uint64_t buf[3];
+            if (fd[e] >= 0 && ::read(fd[e], buf, sizeof(buf)) == ssize_t(sizeof(buf)) && buf[2] > 0)
+                s.value[e] = buf[2] == buf[1] ? buf[0] : uint64_t(double(buf[0]) * buf[1] / buf[2]);
+        }
+        return s;
+    }
+
+    static ThreadCounters& local() {
+        static thread_local ThreadCounters counters;
+        return counters;
+    }
+};
+
+// Small dense id per thread, in order of first use.
+inline int threadIndex() {
+    static std::atomic<int> next{0};
+    static thread_local int id = next++;
+    return id;
+}
+
+struct Totals {
+    uint64_t calls = 0;
+    double seconds = 0.0;
+    double flops = 0.0;
+    double bytes = 0.0;
+    uint64_t value[Events] = {};
+};
+
+// What a region has counted; kept by the registry, so regions that are
+// destroyed before the report at exit still appear in it.
+struct RegionState {
+    std::string name;
+    std::mutex mut;
+    std::map<int, Totals> threads;
+    bool counted[Events] = {};
+    bool team = false;          // some scope's work ran outside its counters
+};
+
+inline std::mutex& registryMutex() {
+    static std::mutex mut;
+    return mut;
+}
+
+inline std::vector<std::shared_ptr<RegionState>>& registry() {
+    static std::vector<std::shared_ptr<RegionState>> regions;
+    return regions;
+}
+
+inline void report(std::ostream& os = std::cerr, bool perThread = false);
+
+class Region {
+private:
+    std::shared_ptr<RegionState> state;
+
+public:
+    explicit Region(std::string name) : state(std::make_shared<RegionState>()) {
+        state->name = std::move(name);
+        if (!enabled())
+            return;
+        std::lock_guard<std::mutex> lock(registryMutex());
+        if (registry().empty())
+            std::atexit([]() { report(std::cerr, perThreadReport()); });
+        registry().push_back(state);
+    }
+    Region(const Region&) = delete;
+    Region& operator=(const Region&) = delete;
+
+    void add(int thread, double seconds, double flops, double bytes, const Sample& delta, const ThreadCounters& c,
+             Span span) {
+        std::lock_guard<std::mutex> lock(state->mut);
+        state->team |= span == Span::Team;
+        Totals& t = state->threads[thread];
+        t.calls++;
+        t.seconds += seconds;
+        t.flops += flops;
+        t.bytes += bytes;
+        for (int e = 0; e < Events; e++)
+        {
+            t.value[e] += delta.value[e];
+            state->counted[e] |= c.available(e);
+        }
+    }
+
+    void reset() {
+        std::lock_guard<std::mutex> lock(state->mut);
+        state->threads.clear();
+        state->team = false;
+    }
+};
+
+class Scope {
+private:
+    Region* region = nullptr;
+    double flops, bytes;
+    Span span;
+    Sample begin;
+    std::chrono::steady_clock::time_point start;
+
+public:
+    Scope(Region& r, double flops = 0.0, double bytes = 0.0, Span span = Span::Thread)
+        : flops(flops), bytes(bytes), span(span) {
+        if (!enabled())
+            return;
+        region = &r;
+        begin = ThreadCounters::local().read();
+        start = std::chrono::steady_clock::now();
+    }
+    ~Scope() {
+        if (!region)
+            return;
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        const ThreadCounters& c = ThreadCounters::local();
+        Sample end = c.read(), delta;
+        for (int e = 0; e < Events; e++)
+            delta.value[e] = end.value[e] - begin.value[e];
+        region->add(threadIndex(), seconds, flops, bytes, delta, c, span);
+    }
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+};
+
+#if defined(__AVX512F__)
+constexpr size_t VectorBytes = 64;
+#elif defined(__AVX__)
+constexpr size_t VectorBytes = 32;
+#else
+constexpr size_t VectorBytes = 16;
+#endif
+
+struct Machine {
+    double gflops = 0.0;        // peak double FMA throughput at this build's vector width
+    double gbps = 0.0;          // triad bandwidth
+    int threads = 1;
+};
+
+constexpr int FmaChains = 16;
+
+#if defined(__GNUC__) && !defined(__NVCOMPILER) && !defined(__PGI)
+// FmaChains independent vector a = a * x + y chains; contracted to FMAs even
+// under -std=c++NN, which otherwise keeps the multiply and the add apart.
+__attribute__((optimize("fp-contract=fast")))
+inline void fmaChains(size_t iters) {
+    typedef double V __attribute__((vector_size(VectorBytes)));
+    V acc[FmaChains], x = V{} + 0.999999, y = V{} + 1e-7;
+    #pragma GCC unroll 16
+    for (int c = 0; c < FmaChains; c++)
+        acc[c] = V{} + double(c);
+    for (size_t it = 0; it < iters; it++)
+        #pragma GCC unroll 16
+        for (int c = 0; c < FmaChains; c++)
+        {
+            acc[c] = acc[c] * x + y;
+            __asm__ volatile("" : "+x"(acc[c]));
+        }
+    volatile double sink = acc[0][0];
+    (void)sink;
+}
+constexpr size_t FmaLanes = VectorBytes / sizeof(double);
+#else
+// Other compilers (pgc++ for the OpenACC builds): scalar chains, so the
+// compute roof is low by the vector width; give PERF_PEAK_GFLOPS instead.
+inline void fmaChains(size_t iters) {
+    double acc[FmaChains], x = 0.999999, y = 1e-7;
+    for (int c = 0; c < FmaChains; c++)
+        acc[c] = c;
+    for (size_t it = 0; it < iters; it++)
+        for (int c = 0; c < FmaChains; c++)
+            acc[c] = acc[c] * x + y;
+    volatile double sink = acc[0];
+    (void)sink;
+}
+constexpr size_t FmaLanes = 1;
+#endif
+
+// Measured on all hardware threads: FMA chains in registers for the compute
+// roof (at the vector width this file is compiled for, so build with
+// -march=native), a triad over 3 x 128 MB for the memory roof.
+inline Machine measureMachine() {
+    Machine m;
+    m.threads = std::max(1u, std::thread::hardware_concurrency());
+    constexpr size_t iters = 20000000;
+    auto start = std::chrono::steady_clock::now();
+    {
+        std::vector<std::thread> pool;
+        for (int t = 0; t < m.threads; t++)
+            pool.emplace_back([]() { fmaChains(iters); });
+        for (auto& th : pool)
+            th.join();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    m.gflops = 2.0 * FmaChains * FmaLanes * iters * m.threads / seconds / 1e9;
+
+    const size_t n = size_t(16) << 20;
+    std::unique_ptr<double[]> a(new double[n]), b(new double[n]), c(new double[n]);
+    auto triad = [&]() {
+        std::vector<std::thread> pool;
+        for (int t = 0; t < m.threads; t++)
+            pool.emplace_back([&, t]() {
+                size_t lo = n * t / m.threads, hi = n * (t + 1) / m.threads;
+                for (size_t i = lo; i < hi; i++)
+                    a[i] = b[i] + 3.0 * c[i];
+            });
+        for (auto& th : pool)
+            th.join();
+    };
+    std::fill(b.get(), b.get() + n, 1.0);
+    std::fill(c.get(), c.get() + n, 2.0);
+    triad();
+    double best = 1e30;
+    for (int rep = 0; rep < 5; rep++)
+    {
+        start = std::chrono::steady_clock::now();
+        triad();
+        best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+    }
+    m.gbps = 3.0 * n * sizeof(double) / best / 1e9;
+    return m;
+}
+
+inline const Machine& machine() {
+    static Machine m = []() {
+        const char* f = std::getenv("PERF_PEAK_GFLOPS");
+        const char* b = std::getenv("PERF_PEAK_GBS");
+        Machine given;
+        if (f && b)
+        {
+            given.gflops = std::atof(f);
+            given.gbps = std::atof(b);
+            return given;
+        }
+        Machine measured = measureMachine();
+        if (f)
+            measured.gflops = std::atof(f);
+        if (b)
+            measured.gbps = std::atof(b);
+        return measured;
+    }();
+    return m;
+}
+
+inline std::string format(double v, int precision, bool valid = true) {
+    if (!valid)
+        return "n/a";
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "%.*f", precision, v);
+    return buf;
+}
+
+void report(std::ostream& os, bool perThread) {
+    std::vector<std::shared_ptr<RegionState>> regions;
+    {
+        std::lock_guard<std::mutex> lock(registryMutex());
+        regions = registry();
+    }
+    if (regions.empty())
+        return;
+    const Machine& m = machine();
+    os << "perf regions: peak " << format(m.gflops, 1) << " GFLOP/s, " << format(m.gbps, 1) << " GB/s, ridge "
+       << format(m.gflops / m.gbps, 2) << " flop/byte, " << m.threads << " hardware threads" << std::endl;
+    os << std::left << std::setw(22) << "region" << std::right << std::setw(8) << "calls" << std::setw(4) << "thr"
+       << std::setw(10) << "s" << std::setw(9) << "GFLOP/s" << std::setw(8) << "GB/s" << std::setw(7) << "AI"
+       << std::setw(9) << "roof" << std::setw(7) << "%roof" << std::setw(9) << "bound" << std::setw(7) << "IPC"
+       << std::setw(9) << "LLC GB/s" << std::endl;
+    for (const auto& r : regions)
+    {
+        bool counted[Events];
+        std::map<int, Totals> threads;
+        {
+            std::lock_guard<std::mutex> lock(r->mut);
+            std::copy(r->counted, r->counted + Events, counted);
+            threads = r->threads;
+            // one thread's counts for work spread over a team would mislead
+            if (r->team)
+                counted[Cycles] = counted[Instructions] = counted[LlcMisses] = false;
+        }
+        if (threads.empty())
+            continue;
+        Totals sum;
+        for (const auto& t : threads)
+        {
+            sum.calls = std::max(sum.calls, t.second.calls);
+            sum.seconds = std::max(sum.seconds, t.second.seconds);
+            sum.flops += t.second.flops;
+            sum.bytes += t.second.bytes;
+            for (int e = 0; e < Events; e++)
+                sum.value[e] += t.second.value[e];
+        }
+        auto line = [&](const std::string& name, const Totals& t, size_t nthreads) {
+            bool roofline = t.flops > 0 && t.bytes > 0 && t.seconds > 0;
+            double gflops = t.flops / t.seconds / 1e9, ai = roofline ? t.flops / t.bytes : 0.0;
+            double roof = std::min(m.gflops, ai * m.gbps);
+            bool ipc = counted[Cycles] && counted[Instructions] && t.value[Cycles] > 0;
+            os << std::left << std::setw(22) << name << std::right << std::setw(8) << t.calls << std::setw(4)
+               << nthreads << std::setw(10) << format(t.seconds, 4) << std::setw(9) << format(gflops, 2, t.flops > 0)
+               << std::setw(8) << format(t.bytes / t.seconds / 1e9, 2, t.bytes > 0) << std::setw(7)
+               << format(ai, 3, roofline) << std::setw(9) << format(roof, 2, roofline) << std::setw(7)
+               << format(100.0 * gflops / roof, 0, roofline) << std::setw(9)
+               << (roofline ? (ai < m.gflops / m.gbps ? "memory" : "compute") : "-") << std::setw(7)
+               << format(double(t.value[Instructions]) / t.value[Cycles], 2, ipc) << std::setw(9)
+               << format(t.value[LlcMisses] * 64.0 / t.seconds / 1e9, 2, counted[LlcMisses]) << std::endl;
+        };
+        line(r->name, sum, threads.size());
+        if (perThread && threads.size() > 1)
+            for (const auto& t : threads)
+                line("  thread " + std::to_string(t.first), t.second, 1);
+    }
+}
+
+}
@@ -0,0 +1,99 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+// Counter-based random numbers (Philox4x32-10, Salmon et al., SC'11).
+// A value is a pure function of (seed, stream, index): no state is shared
+// between threads, any index can be computed directly, and a range of them
+// is an independent loop the compiler can vectorise. Give every client,
+// thread or rank its own stream and the inputs are the same however the
+// work is split.
+namespace philox {
+
+using Block = std::array<uint32_t, 4>;
+
+// 10 rounds on the 128-bit counter with a 64-bit key.
+inline Block block(Block c, uint32_t k0, uint32_t k1) {
+    for (int r = 0; r < 10; r++)
+    {
+        if (r > 0)
+        {
+            k0 += 0x9E3779B9u;
+            k1 += 0xBB67AE85u;
+        }
+        uint64_t p0 = uint64_t(0xD2511F53u) * c[0];
+        uint64_t p1 = uint64_t(0xCD9E8D57u) * c[2];
+        c = {uint32_t(p1 >> 32) ^ c[1] ^ k0, uint32_t(p1), uint32_t(p0 >> 32) ^ c[3] ^ k1, uint32_t(p0)};
+    }
+    return c;
+}
+
+// Counter = (index, stream), key = seed.
+inline Block block(uint64_t seed, uint64_t stream, uint64_t index) {
+    return block({uint32_t(index), uint32_t(index >> 32), uint32_t(stream), uint32_t(stream >> 32)},
+                 uint32_t(seed), uint32_t(seed >> 32));
+}
+
+// 53 random bits as a double in [0, 1).
+inline double toUnit(uint32_t hi, uint32_t lo) {
+    return double(((uint64_t(hi) << 32) | lo) >> 11) * 0x1.0p-53;
+}
+
+// Value number `index` of the stream, uniform in [lo, hi).
+inline double uniform(uint64_t seed, uint64_t stream, uint64_t index, double lo = 0.0, double hi = 1.0) {
+    Block b = block(seed, stream, index);
+    return lo + (hi - lo) * toUnit(b[0], b[1]);
+}
+
+// out[i] = uniform(seed, stream, first + i, lo, hi); one block per value, so
+// the iterations are independent and a slice can go to any thread.
+inline void uniform(double* out, size_t n, uint64_t seed, uint64_t stream, uint64_t first,
+                    double lo = 0.0, double hi = 1.0) {
+#ifdef _OPENMP
+    #pragma omp simd
+#endif
+    for (size_t i = 0; i < n; i++)
+        out[i] = uniform(seed, stream, first + i, lo, hi);
+}
+
+// UniformRandomBitGenerator over one stream, for the <random> distributions.
+// Four 32-bit words per counter value; seek jumps to any word directly.
+class Engine {
+private:
+    uint64_t seedValue;
+    uint64_t streamId;
+    uint64_t counter = 0;
+    Block buf{};
+    int pos = 4;
+public:
+    using result_type = uint32_t;
+
+    Engine(uint64_t seed, uint64_t stream) : seedValue(seed), streamId(stream) {}
+
+    static constexpr result_type min() {
+        return 0;
+    }
+    static constexpr result_type max() {
+        return std::numeric_limits<uint32_t>::max();
+    }
+
+    result_type operator()() {
+        if (pos == 4)
+        {
+            buf = block(seedValue, streamId, counter++);
+            pos = 0;
+        }
+        return buf[pos++];
+    }
+
+    void seek(uint64_t word) {
+        counter = word / 4;
+        pos = 4;
+        for (uint64_t k = 0; k < word % 4; k++)
+            (*this)();
+    }
+};
+
+}
@@ -0,0 +1,89 @@
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <thread>
+#include <random>
+#include <chrono>
+#include <string>
+#include <cstdlib>
+#include "philox.hpp"
+
+// Uniform doubles per second: the task3.2 generator (default_random_engine +
+// uniform_real_distribution, one stream, sequential), Philox one call at a
+// time, the vectorised batch fill, and the batch fill split over threads.
+// The threaded result is compared with the single-threaded one.
+// usage: philox_bench [n] [threads]
+
+template <class F>
+double timed(F f) {
+    auto start = std::chrono::steady_clock::now();
+    f();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void report(const std::string& name, size_t n, double seconds, double check) {
+    std::cout << std::left << std::setw(30) << name << std::right << std::fixed << std::setprecision(1)
+              << std::setw(10) << n / seconds / 1e6 << std::setw(14) << std::setprecision(6) << check / n << std::endl;
+}
+
+int main(int argc, char const *argv[])
+{
+    size_t n = argc > 1 ? std::atol(argv[1]) : (size_t(1) << 25);
+    int threads = argc > 2 ? std::atoi(argv[2]) : std::max(1u, std::thread::hardware_concurrency());
+    const uint64_t seed = 2024, stream = 1;
+    std::vector<double> a(n), b(n);
+    std::cout << n << " values, " << threads << " threads" << std::endl;
+    std::cout << std::left << std::setw(30) << "generator" << std::right << std::setw(10) << "M/s" << std::setw(14)
+              << "mean" << std::endl;
+
+    double t = timed([&]() {
+        std::default_random_engine gen;
+        std::uniform_real_distribution<double> distr(0.0, 1.0);
+        for (size_t i = 0; i < n; i++)
+            a[i] = distr(gen);
+    });
+    double sum = 0.0;
+    for (double v : a)
+        sum += v;
+    report("default_random_engine", n, t, sum);
+
+    t = timed([&]() {
+        philox::Engine gen(seed, stream);
+        std::uniform_real_distribution<double> distr(0.0, 1.0);
+        for (size_t i = 0; i < n; i++)
+            a[i] = distr(gen);
+    });
+    sum = 0.0;
+    for (double v : a)
+        sum += v;
+    report("philox::Engine + distribution", n, t, sum);
+
+    t = timed([&]() {
+        for (size_t i = 0; i < n; i++)
+            a[i] = philox::uniform(seed, stream, i);
+    });
+    sum = 0.0;
+    for (double v : a)
+        sum += v;
+    report("philox::uniform, per call", n, t, sum);
+
+    t = timed([&]() { philox::uniform(a.data(), n, seed, stream, 0); });
+    sum = 0.0;
+    for (double v : a)
+        sum += v;
+    report("philox::uniform, batch", n, t, sum);
+
+    t = timed([&]() {
+        std::vector<std::thread> pool;
+        for (int k = 0; k < threads; k++)
+            pool.emplace_back([&, k]() {
+                size_t lo = n * k / threads, hi = n * (k + 1) / threads;
+                philox::uniform(b.data() + lo, hi - lo, seed, stream, lo);
+            });
+        for (auto& th : pool)
+            th.join();
+    });
+    report("philox::uniform, batch, threads", n, t, sum);
+    std::cout << "threaded batch " << (a == b ? "identical" : "DIFFERS") << std::endl;
+    return a == b ? 0 : 1;
+}
@@ -0,0 +1,188 @@
+#pragma once
+// CPU counterpart of the CUDA graph in task8: a fixed sequence of parallel
+// loops and reductions is recorded once and then replayed on a persistent
+// thread team. Between steps the threads only meet at a spin barrier, so a
+// replay of K steps costs K barriers instead of K fork/joins; the team is
+// woken once per replay.
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <vector>
+#include <algorithm>
+
+class SpinBarrier {
+private:
+    int count;
+    std::atomic<int> waiting{0};
+    std::atomic<int> phase{0};
+public:
+    explicit SpinBarrier(int count) : count(count) {}
+
+    void wait() {
+        int p = phase.load(std::memory_order_acquire);
+        if (waiting.fetch_add(1, std::memory_order_acq_rel) == count - 1)
+        {
+            waiting.store(0, std::memory_order_relaxed);
+            phase.store(p + 1, std::memory_order_release);
+            return;
+        }
+        for (int spins = 0; phase.load(std::memory_order_acquire) == p; spins++)
+            if (spins > 1000)
+                std::this_thread::yield();
+    }
+};
+
+class TaskGraph {
+public:
+    // body(begin, end) gets a contiguous slice of [0, count)
+    using Body = std::function<void(size_t, size_t)>;
+    using ReduceBody = std::function<double(size_t, size_t)>;
+
+private:
+    struct Step {
+        size_t count;
+        Body body;
+        ReduceBody reduce;
+        double* out;
+        std::function<void()> serial;
+    };
+    struct alignas(64) Partial {
+        double value;
+    };
+
+    int nthreads;
+    std::vector<Step> steps;
+    std::vector<Partial> partial;
+    std::vector<std::thread> workers;
+    SpinBarrier barrier;
+    std::mutex mut;
+    std::condition_variable cv;
+    long generation = 0;
+    int replays = 0;
+    int finished = 0;
+    bool quit = false;
+
+    // seq counts executed steps across repeated replays, identically on every thread
+    void runSteps(int tid, size_t& seq) {
+        for (const Step& s : steps)
+        {
+            // partials alternate between two banks: a worker may already be in
+            // the next step while thread 0 is still folding this one
+            Partial* bank = &partial[(seq++ & 1) * nthreads];
+            if (s.serial)
+            {
+                if (tid == 0)
+                    s.serial();
+            }
+            else
+            {
+                size_t per = (s.count + nthreads - 1) / nthreads;
+                size_t b = std::min(s.count, per * tid);
+                size_t e = std::min(s.count, b + per);
+                if (s.reduce)
+                    bank[tid].value = b < e ? s.reduce(b, e) : 0.0;
+                else if (b < e)
+                    s.body(b, e);
+            }
+            barrier.wait();
+            // thread 0 folds the partials before it starts the next step; only
+            // serial steps (also thread 0) and the caller read the result
+            if (s.reduce && tid == 0)
+            {
+                double m = bank[0].value;
+                for (int t = 1; t < nthreads; t++)
+                    m = std::max(m, bank[t].value);
+                *s.out = m;
+            }
+        }
+    }
+
+    void worker(int tid) {
+        long seen = 0;
+        while (true)
+        {
+            int times;
+            {
+                std::unique_lock<std::mutex> lock(mut);
+                cv.wait(lock, [&]() { return quit || generation != seen; });
+                if (quit)
+                    return;
+                seen = generation;
+                times = replays;
+            }
+            size_t seq = 0;
+            for (int r = 0; r < times; r++)
+                runSteps(tid, seq);
+            {
+                std::unique_lock<std::mutex> lock(mut);
+                finished++;
+            }
+            cv.notify_all();
+        }
+    }
+
+public:
+    explicit TaskGraph(int threads)
+        : nthreads(std::max(threads, 1)), partial(2 * nthreads), barrier(nthreads) {
+        for (int t = 1; t < nthreads; t++)
+            workers.emplace_back(&TaskGraph::worker, this, t);
+    }
+
+    ~TaskGraph() {
+        {
+            std::unique_lock<std::mutex> lock(mut);
+            quit = true;
+        }
+        cv.notify_all();
+        for (auto& w : workers)
+            w.join();
+    }
+
+    TaskGraph(const TaskGraph&) = delete;
+    TaskGraph& operator=(const TaskGraph&) = delete;
+
+    int threads() const {
+        return nthreads;
+    }
+
+    size_t size() const {
+        return steps.size();
+    }
+
+    void clear() {
+        steps.clear();
+    }
+
+    // Parallel loop over [0, count).
+    void addParallel(size_t count, Body body) {
+        steps.push_back({count, std::move(body), nullptr, nullptr, nullptr});
+    }
+
+    // Parallel max-reduction over [0, count); *out holds the result after the step.
+    void addReduceMax(size_t count, ReduceBody body, double* out) {
+        steps.push_back({count, nullptr, std::move(body), out, nullptr});
+    }
+
+    // Runs on one thread between two parallel steps.
+    void addSerial(std::function<void()> fn) {
+        steps.push_back({0, nullptr, nullptr, nullptr, std::move(fn)});
+    }
+
+    // Executes the recorded steps `times` times; the calling thread is thread 0.
+    void replay(int times = 1) {
+        {
+            std::unique_lock<std::mutex> lock(mut);
+            replays = times;
+            finished = 0;
+            generation++;
+        }
+        cv.notify_all();
+        size_t seq = 0;
+        for (int r = 0; r < times; r++)
+            runSteps(0, seq);
+        std::unique_lock<std::mutex> lock(mut);
+        cv.wait(lock, [&]() { return finished == nthreads - 1; });
+    }
+};
@@ -0,0 +1,87 @@
+#pragma once
+// Host vector primitives with the semantics of the cuBLAS calls used in
+// task7 (daxpy, idamax, dcopy) plus the fused max|a-b| that replaces the
+// three of them in the convergence check. OpenMP threads split the vector,
+// each thread runs a simd loop over its part. Build with -fopenmp; without
+// it everything runs on one thread.
+#include <cstddef>
+#include <cmath>
+#include <algorithm>
+#include <limits>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace vecops {
+
+// y = alpha * x + y
+template <class T>
+void axpy(size_t n, T alpha, const T* x, T* y) {
+    #pragma omp parallel for simd schedule(static)
+    for (size_t k = 0; k < n; k++)
+        y[k] += alpha * x[k];
+}
+
+// y = x
+template <class T>
+void copy(size_t n, const T* x, T* y) {
+    #pragma omp parallel for simd schedule(static)
+    for (size_t k = 0; k < n; k++)
+        y[k] = x[k];
+}
+
+// Index of the first element with the largest |x|, 0-based (cuBLAS i?amax is 1-based).
+template <class T>
+size_t iamax(size_t n, const T* x) {
+    constexpr size_t block = 4096;
+    size_t best = 0;
+    T bestVal = -1;
+    #pragma omp parallel
+    {
+        size_t localIdx = 0;
+        T localVal = -1;
+        #pragma omp for schedule(static) nowait
+        for (size_t b = 0; b < n; b += block)
+        {
+            size_t e = std::min(n, b + block);
+            T m = 0;
+            #pragma omp simd reduction(max:m)
+            for (size_t k = b; k < e; k++)
+                m = std::max(m, std::fabs(x[k]));
+            // the block is still in cache, find where the max sits only if it beats ours
+            if (m > localVal)
+            {
+                for (size_t k = b; k < e; k++)
+                    if (std::fabs(x[k]) == m)
+                    {
+                        localIdx = k;
+                        break;
+                    }
+                localVal = m;
+            }
+        }
+        #pragma omp critical
+        if (localVal > bestVal || (localVal == bestVal && localIdx < best))
+        {
+            best = localIdx;
+            bestVal = localVal;
+        }
+    }
+    return best;
+}
+
+// max |a - b| in one pass, neither input is modified. A NaN difference
+// counts as +inf, so a diverged solver never passes its convergence check.
+template <class T>
+T max_abs_diff(size_t n, const T* a, const T* b) {
+    T m = 0;
+    #pragma omp parallel for simd schedule(static) reduction(max:m)
+    for (size_t k = 0; k < n; k++)
+    {
+        T d = std::fabs(a[k] - b[k]);
+        m = d == d ? std::max(m, d) : std::numeric_limits<T>::infinity();
+    }
+    return m;
+}
+
+}
@@ -0,0 +1,61 @@
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <cmath>
+#include <omp.h>
+#include "vecops.hpp"
+
+// Convergence check of task7: axpy + iamax + copy (three passes, one of them
+// destructive) against the fused max_abs_diff. usage: vecops_bench [N] [reps]
+int main(int argc, char const *argv[])
+{
+    size_t N = argc > 1 ? std::atol(argv[1]) : 4096;
+    int reps = argc > 2 ? std::atoi(argv[2]) : 20;
+    size_t len = N * N;
+    std::vector<double> a(len), b(len);
+    #pragma omp parallel for
+    for (size_t k = 0; k < len; k++)
+    {
+        a[k] = std::sin(0.001 * k);
+        b[k] = a[k] + 1e-7 * std::cos(0.37 * k);
+    }
+
+    double err3 = 0.0, errF = 0.0;
+    double t3 = omp_get_wtime();
+    for (int r = 0; r < reps; r++)
+    {
+        vecops::axpy(len, -1.0, a.data(), b.data());
+        size_t idx = vecops::iamax(len, b.data());
+        err3 = std::fabs(b[idx]);
+        vecops::copy(len, a.data(), b.data());
+        // put b back to a+delta so every repetition sees the same data
+        #pragma omp parallel for
+        for (size_t k = 0; k < len; k++)
+            b[k] = a[k] + 1e-7 * std::cos(0.37 * k);
+    }
+    t3 = omp_get_wtime() - t3;
+    double tRestore = omp_get_wtime();
+    for (int r = 0; r < reps; r++)
+    {
+        #pragma omp parallel for
+        for (size_t k = 0; k < len; k++)
+            b[k] = a[k] + 1e-7 * std::cos(0.37 * k);
+    }
+    tRestore = omp_get_wtime() - tRestore;
+    t3 -= tRestore;
+
+    double tF = omp_get_wtime();
+    for (int r = 0; r < reps; r++)
+        errF = vecops::max_abs_diff(len, a.data(), b.data());
+    tF = omp_get_wtime() - tF;
+
+    double gb = double(len) * sizeof(double) / 1e9;
+    std::cout << "N = " << N << ", " << omp_get_max_threads() << " threads, " << reps << " reps" << std::endl;
+    std::cout << std::fixed << std::setprecision(3);
+    std::cout << "axpy+iamax+copy: " << t3 / reps * 1000 << " ms/check, "
+              << 6 * gb * reps / t3 << " GB/s, error " << std::scientific << err3 << std::fixed << std::endl;
+    std::cout << "max_abs_diff:    " << tF / reps * 1000 << " ms/check, "
+              << 2 * gb * reps / tF << " GB/s, error " << std::scientific << errF << std::fixed << std::endl;
+    std::cout << "fused speedup: " << t3 / tF << "x" << std::endl;
+    return err3 == errF ? 0 : 1;
+}
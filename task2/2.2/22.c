@@ -1,4 +1,5 @@
 #include <stdio.h>
+#include <stdlib.h>
 #include <math.h>
 #include <time.h>
 #include <omp.h>
@@ -57,6 +58,42 @@ double integrate_omp(double (*func)(double), double a, double b, int n)
     return sum;
 }
 
+// Same sum, but independent of the thread count (common/detsum.hpp in C):
+// fixed CHUNK-sized pieces summed in order, then a fixed pairwise tree.
+#define CHUNK 1024
+
+double tree_sum(const double *p, int n)
+{
+    if (n == 0)
+        return 0.0;
+    if (n == 1)
+        return p[0];
+    int half = 1;
+    while (half * 2 < n)
+        half *= 2;
+    return tree_sum(p, half) + tree_sum(p + half, n - half);
+}
+
+double integrate_omp_det(double (*func)(double), double a, double b, int n)
+{
+    double h = (b - a) / n;
+    int chunks = (n + CHUNK - 1) / CHUNK;
+    double *partial = (double*)malloc(sizeof(*partial) * chunks);
+
+#pragma omp parallel for schedule(static)
+    for (int c = 0; c < chunks; c++)
+    {
+        int ub = (c + 1) * CHUNK < n ? (c + 1) * CHUNK : n;
+        double sumloc = 0.0;
+        for (int i = c * CHUNK; i < ub; i++)
+            sumloc += func(a + h * (i + 0.5));
+        partial[c] = sumloc;
+    }
+    double sum = tree_sum(partial, chunks) * h;
+    free(partial);
+    return sum;
+}
+
 double run_serial()
 {
     double t = cpuSecond();
@@ -70,7 +107,15 @@ double run_parallel()
     double t = cpuSecond();
     double res = integrate_omp(func, a, b, nsteps);
     t = cpuSecond() - t;
-    printf("Result (parallel): %.12f; error %.12f\n", res, fabs(res - sqrt(PI)));
+    printf("Result (parallel): %.12f; error %.12f; bits %a\n", res, fabs(res - sqrt(PI)), res);
+    return t;
+}
+double run_parallel_det()
+{
+    double t = cpuSecond();
+    double res = integrate_omp_det(func, a, b, nsteps);
+    t = cpuSecond() - t;
+    printf("Result (deterministic): %.12f; error %.12f; bits %a\n", res, fabs(res - sqrt(PI)), res);
     return t;
 }
 int main(int argc, char **argv)
@@ -78,9 +123,11 @@ int main(int argc, char **argv)
     printf("Integration f(x) on [%.12f, %.12f], nsteps = %d\n", a, b, nsteps);
     double tserial = run_serial();
     double tparallel = run_parallel();
+    double tdet = run_parallel_det();
 
     printf("Execution time (serial): %.6f\n", tserial);
     printf("Execution time (parallel): %.6f\n", tparallel);
+    printf("Execution time (deterministic): %.6f\n", tdet);
     printf("Speedup: %.2f\n", tserial / tparallel);
     return 0;
 }
\ No newline at end of file
@@ -6,6 +6,10 @@
 #include <string>
 #include <cstring>
 #include <omp.h>
+#include "../../../common/grid_alloc.hpp"
+#include "../../../common/detsum.hpp"
+#include "../../../common/perf_regions.hpp"
+#include "../../../common/autotune.hpp"
 
 int n = 17000;
 double tau = 0.0001;
@@ -20,40 +24,83 @@ double cpuSecond()
 }
 
 
-void algor(double* matr, double* vec, double* x, double* x1, double down, int num_threads)
+// up = sum upp[i]: detsum by default, the same bits for any num_threads;
+// with atomicSum the old omp atomic, whose order (and so the iteration the
+// solver stops at) depends on how the threads finish.
+int algor(double* matr, double* vec, double* x, double* x1, double down, int num_threads, bool atomicSum)
 {
-    std::unique_ptr<double[]> upp(new double[n]);
+    auto upp = grid_alloc::make_array<double>(n);
+    int iterations = 0;
+    // PERF_REGIONS=1: one scope per thread and iteration, counted as its share
+    // of the matvec (2 flops and 8 bytes of the matrix per element)
+    static perf_regions::Region region("solver iteration");
     while(true)
     {
+        iterations++;
         double up = 0.0;
-#pragma omp parallel for num_threads(num_threads)
-        for (size_t i = 0; i < n; i++)
+#pragma omp parallel num_threads(num_threads)
         {
-            for (size_t j = 0; j < n; j++)
+            int share = omp_get_num_threads();
+            perf_regions::Scope scope(region, 2.0 * n * n / share, 8.0 * n * n / share);
+#pragma omp for schedule(runtime)
+            for (size_t i = 0; i < n; i++)
             {
-                x1[i] += matr[i * n + j] * x[j];
+                for (size_t j = 0; j < n; j++)
+                {
+                    x1[i] += matr[i * n + j] * x[j];
+                }
+                x1[i] = x1[i] - vec[i];
+                upp[i] = pow(x1[i], 2);
+                x1[i] = x[i] - tau * x1[i];
+                if (atomicSum)
+                {
+#pragma omp atomic
+                    up += upp[i];
+                }
             }
-            x1[i] = x1[i] - vec[i];
-            upp[i] = pow(x1[i], 2);
-            x1[i] = x[i] - tau * x1[i];
-#pragma omp atomic 
-            up += upp[i];
         }
+        if (!atomicSum)
+            up = detsum::sum(upp.get(), n, num_threads);
         if (sqrt(up)/sqrt(down) < epsilon)
         {
-            break;
+            return iterations;
         }
         // std::cout << sqrt(up)/sqrt(down) << ' ' << x1[0] << std::endl;
         std::memcpy(x, x1, sizeof(double)*n);
     }
 }
 
+// Threads "auto": threads, schedule and chunk of the solver loop come from the
+// machine profile (common/autotune.hpp); with AUTOTUNE=tune every combination
+// is timed on one matvec first and the winner is saved.
+autotune::Config tune(const double* matr, const double* x, int n)
+{
+    autotune::Space space = {
+        {"threads", autotune::threadCounts()},
+        {"schedule", {omp_sched_static, omp_sched_dynamic, omp_sched_guided}},
+        {"chunk", {0, 64, 512}}};
+    auto y = grid_alloc::make_array<double>(n);
+    return autotune::select("task2.3/solver", n, space, [&](const autotune::Config& c) {
+        omp_set_schedule(omp_sched_t(c.at("schedule")), c.at("chunk"));
+#pragma omp parallel for num_threads(c.at("threads")) schedule(runtime)
+        for (size_t i = 0; i < n; i++)
+        {
+            double s = 0.0;
+            for (size_t j = 0; j < n; j++)
+                s += matr[i * n + j] * x[j];
+            y[i] = s;
+        }
+    });
+}
+
 int main(int argc, char **argv){
-int num_threads = atoi(argv[1]);
-std::unique_ptr<double[]> matr(new double[n*n]);
-std::unique_ptr<double[]> vec(new double[n]);
-std::unique_ptr<double[]> x(new double[n]);
-std::unique_ptr<double[]> x1(new double[n]);
+bool autoThreads = std::string(argv[1]) == "auto";
+int num_threads = autoThreads ? omp_get_max_threads() : atoi(argv[1]);
+bool atomicSum = argc > 2 && std::string(argv[2]) == "atomic";
+auto matr = grid_alloc::make_array<double>(size_t(n) * n);
+auto vec = grid_alloc::make_array<double>(n);
+auto x = grid_alloc::make_array<double>(n);
+auto x1 = grid_alloc::make_array<double>(n);
 #pragma omp parallel for num_threads(num_threads)
 for (size_t i = 0; i < n; i++)
 {
@@ -75,14 +122,23 @@ for (size_t i = 0; i < n; i++)
    
 }
 double down = pow(n + 1, 2) * n;
+omp_set_schedule(omp_sched_static, 0);
+if (autoThreads)
+{
+    autotune::Config c = tune(matr.get(), x.get(), n);
+    num_threads = c.at("threads");
+    omp_set_schedule(omp_sched_t(c.at("schedule")), c.at("chunk"));
+    std::cout << "tuned: " << autotune::format(c) << std::endl;
+}
 
 double time = cpuSecond();
-   algor(matr.get(), vec.get(), x.get(), x1.get(), down, num_threads);
+   int iterations = algor(matr.get(), vec.get(), x.get(), x1.get(), down, num_threads, atomicSum);
    
 time = cpuSecond() - time;
 for (size_t i = 0; i < 10; i++)
 {
     std::cout<< 'x' << i << '=' << ' ' << x1[i] << ' ' << std::endl;
 }
+std::cout << iterations << " iterations, x0 bits " << std::hexfloat << x1[0] << std::defaultfloat << std::endl;
 std:: cout << ' ' << time << "sec." << std::endl;
 }
\ No newline at end of file
@@ -0,0 +1,142 @@
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <cmath>
+#include <chrono>
+#include <boost/program_options.hpp>
+#include "../../common/grid_io.hpp"
+#include "../../common/grid_alloc.hpp"
+#include "../../common/panel_matvec.hpp"
+namespace opt = boost::program_options;
+
+// Matrix-vector product with the matrix in a grid file (common/grid_io.hpp).
+//
+//   stream_matvec --write A.grid --rows 16384 --cols 16384
+//       writes the task3.1 matrix (a[i][j] = j) a panel at a time, so the
+//       file may be larger than memory;
+//   stream_matvec --matrix A.grid --prefetch all --cold --memory
+//       multiplies it by x[j] = j streaming row panels from the mapping,
+//       once per prefetch mode, and (--memory) with the whole matrix read
+//       into RAM first for comparison. --cold evicts the file from the page
+//       cache before every streamed run.
+
+using panel_matvec::Prefetch;
+
+size_t peakRssMB() {
+    std::ifstream status("/proc/self/status");
+    std::string key;
+    size_t kb = 0;
+    while (status >> key)
+        if (key == "VmHWM:" && status >> kb)
+            break;
+    return kb / 1024;
+}
+
+// max relative error against sum_j j^2
+double check(const std::vector<double>& y, size_t n) {
+    double expect = double(n - 1) * n * (2.0 * n - 1) / 6.0, err = 0.0;
+    for (double v : y)
+        err = std::max(err, std::fabs(v - expect) / expect);
+    return err;
+}
+
+void report(const std::string& name, double seconds, double bytes, double err) {
+    std::cout << std::left << std::setw(22) << name << std::right << std::fixed << std::setprecision(3)
+              << std::setw(10) << seconds << std::setw(10) << bytes / seconds / 1e9 << std::setw(12)
+              << std::scientific << std::setprecision(1) << err << std::defaultfloat << std::endl;
+}
+
+int main(int argc, char const *argv[])
+{
+    opt::options_description desc("Argument");
+    desc.add_options()
+        ("write",opt::value<std::string>(),"Write the task3.1 matrix to this grid file")
+        ("rows",opt::value<size_t>()->default_value(16384),"Rows to write")
+        ("cols",opt::value<size_t>()->default_value(16384),"Columns to write")
+        ("matrix",opt::value<std::string>(),"Grid file to multiply")
+        ("threads",opt::value<int>()->default_value(1),"Threads per panel")
+        ("panel",opt::value<size_t>()->default_value(64),"Panel size, MB")
+        ("prefetch",opt::value<std::string>()->default_value("thread"),"none, advise, thread or all")
+        ("cold",opt::bool_switch(),"Evict the file from the page cache before each streamed run")
+        ("keep",opt::bool_switch(),"Keep finished panels mapped (no drop)")
+        ("memory",opt::bool_switch(),"Also time the product with the matrix in RAM")
+        ("help","help");
+    opt::variables_map vm;
+    opt::store(opt::parse_command_line(argc, argv, desc), vm);
+    opt::notify(vm);
+    if (vm.count("help") || (!vm.count("write") && !vm.count("matrix"))) {
+        std::cout << desc << "\n";
+        return 1;
+    }
+    size_t panelBytes = vm["panel"].as<size_t>() << 20;
+
+    if (vm.count("write"))
+    {
+        size_t m = vm["rows"].as<size_t>(), n = vm["cols"].as<size_t>();
+        grid_io::MappedGrid<double> out;
+        if (!out.create(vm["write"].as<std::string>(), m, n))
+            return 1;
+        size_t panelRows = std::max<size_t>(1, panelBytes / (n * sizeof(double)));
+        auto start = std::chrono::steady_clock::now();
+        for (size_t r0 = 0; r0 < m; r0 += panelRows)
+        {
+            size_t r1 = std::min(m, r0 + panelRows);
+            double* a = out.data();
+            for (size_t k = r0 * n; k < r1 * n; k++)
+                a[k] = k % n;
+            out.drop(r0 * n, (r1 - r0) * n);
+        }
+        std::chrono::duration<double> d = std::chrono::steady_clock::now() - start;
+        std::cout << "wrote " << m << " x " << n << " (" << m * n * 8 / 1e9 << " GB) in " << d.count() << " s" << std::endl;
+        if (!vm.count("matrix"))
+            return 0;
+    }
+
+    grid_io::MappedGrid<double> A;
+    if (!A.open(vm["matrix"].as<std::string>()))
+        return 1;
+    size_t m = A.rows * A.depth, n = A.cols;
+    std::vector<double> x(n), y(m);
+    for (size_t j = 0; j < n; j++)
+        x[j] = j;
+    std::cout << m << " x " << n << ", " << m * n * 8 / 1e9 << " GB, panel " << vm["panel"].as<size_t>() << " MB, "
+              << vm["threads"].as<int>() << " threads" << (vm["cold"].as<bool>() ? ", cold cache" : "") << std::endl;
+    std::cout << std::left << std::setw(22) << "kernel" << std::right << std::setw(10) << "s" << std::setw(10)
+              << "GB/s" << std::setw(12) << "rel. error" << std::endl;
+
+    std::string mode = vm["prefetch"].as<std::string>();
+    std::vector<std::pair<std::string, Prefetch>> modes;
+    if (mode == "none" || mode == "all")
+        modes.push_back({"stream, no prefetch", Prefetch::None});
+    if (mode == "advise" || mode == "all")
+        modes.push_back({"stream, madvise", Prefetch::Advise});
+    if (mode == "thread" || mode == "all")
+        modes.push_back({"stream, thread", Prefetch::Thread});
+    for (const auto& md : modes)
+    {
+        if (vm["cold"].as<bool>())
+            A.dropAll();
+        panel_matvec::Options o;
+        o.panelBytes = panelBytes;
+        o.threads = vm["threads"].as<int>();
+        o.prefetch = md.second;
+        o.drop = !vm["keep"].as<bool>();
+        panel_matvec::Stats s = panel_matvec::multiply(A, x.data(), y.data(), o);
+        report(md.first, s.seconds, s.bytes, check(y, n));
+    }
+    std::cout << "peak RSS while streaming: " << peakRssMB() << " MB" << std::endl;
+
+    if (vm["memory"].as<bool>())
+    {
+        auto a = grid_alloc::make_array<double>(m * n);
+        std::copy(A.data(), A.data() + m * n, a.get());
+        A.dropAll();
+        auto start = std::chrono::steady_clock::now();
+        panel_matvec::multiplyRows(a.get(), x.data(), y.data(), 0, m, n, vm["threads"].as<int>());
+        std::chrono::duration<double> d = std::chrono::steady_clock::now() - start;
+        report("in memory", d.count(), double(m) * n * 8, check(y, n));
+    }
+    return 0;
+}
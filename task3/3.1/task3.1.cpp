@@ -4,6 +4,10 @@
 #include <memory>
 #include <cstring>
 #include <chrono>
+#include <string>
+#include "../../common/grid_alloc.hpp"
+#include "../../common/perf_regions.hpp"
+#include "../../common/autotune.hpp"
 
 double cpuSecond()
 {
@@ -12,8 +16,13 @@ double cpuSecond()
     return std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count() * 1e-9;
 }
 
+// PERF_REGIONS=1: each thread's rows are one scope (2 flops and 8 bytes of
+// the matrix per element), the report shows the threads and their total.
+perf_regions::Region parallelRegion("matvec, threads");
+perf_regions::Region serialRegion("matvec, serial");
+
 void multiplyElements(double* arr1, double* arr2, double* result, size_t lb, size_t ub, size_t id, size_t m, size_t n) {
-    
+    perf_regions::Scope scope(parallelRegion, 2.0 * (ub - lb + 1) * n, 8.0 * (ub - lb + 1) * n);
     for (size_t i = lb; i <= ub; ++i) {
          double sum = 0.0;
         for (size_t j = 0; j < n; j++)
@@ -26,7 +35,7 @@ void multiplyElements(double* arr1, double* arr2, double* result, size_t lb, siz
 }
 
 void multiplyElements_sumple(double* arr1, double* arr2, double* result, size_t m, size_t n) {
-    
+    perf_regions::Scope scope(serialRegion, 2.0 * m * n, 8.0 * m * n);
     for (size_t i = 0; i <= m; ++i) {
          double sum = 0.0;
         for (size_t j = 0; j < n; j++)
@@ -42,36 +51,48 @@ int main(int argc, char** argv) {
     int n = 10000, m = 10000;
     double time_s, time_p;
     int nt = 2;
-    nt = atoi(argv[1]);
-    std::unique_ptr<double[]> arr1(new double[m*n]);
-    std::unique_ptr<double[]> arr2(new double[n]);
-    std::unique_ptr<double[]> result(new double[m]);
+    bool autoThreads = std::string(argv[1]) == "auto";
+    nt = autoThreads ? int(std::max(1u, std::thread::hardware_concurrency())) : atoi(argv[1]);
+    auto arr1 = grid_alloc::make_array<double>(size_t(m) * n);
+    auto arr2 = grid_alloc::make_array<double>(n);
+    auto result = grid_alloc::make_array<double>(m);
 
-    for (size_t i = 0; i < m; i++)
-    {
-        for (size_t j = 0; j < n; j++)
-        {
-            arr1[i * n + j] = j;
-        }
-    }
+    // filled by nt threads in contiguous slices, roughly the rows each one multiplies later
+    grid_alloc::firstTouch<double>(size_t(m) * n, [&](size_t b, size_t e) {
+        for (size_t k = b; k < e; k++)
+            arr1[k] = k % n;
+    }, nt);
     for (size_t i = 0; i < n; i++)
     {
        arr2[i] = i;
     }
     
     
-    std::vector<std::jthread> threads;
-    int items_per_thread = m / nt;
-    time_p = cpuSecond();
-    for (size_t i = 0; i < nt; ++i) {
-        int lb = i * items_per_thread;
-        int ub = (i == nt - 1) ? (m - 1) : (lb + items_per_thread - 1);
-        threads.emplace_back(multiplyElements, arr1.get() , arr2.get() , result.get() , lb, ub, i, m, n);
-    }
+    auto parallel = [&](int nt) {
+        std::vector<std::jthread> threads;
+        int items_per_thread = m / nt;
+        for (size_t i = 0; i < nt; ++i) {
+            int lb = i * items_per_thread;
+            int ub = (i == nt - 1) ? (m - 1) : (lb + items_per_thread - 1);
+            threads.emplace_back(multiplyElements, arr1.get() , arr2.get() , result.get() , lb, ub, i, m, n);
+        }
 
-    for (auto& thread : threads) {
-        thread.join();
+        for (auto& thread : threads) {
+            thread.join();
+        }
+    };
+    // nt "auto": from the machine profile, or timed here with AUTOTUNE=tune (common/autotune.hpp)
+    if (autoThreads)
+    {
+        autotune::Space space = {{"threads", autotune::threadCounts()}};
+        nt = autotune::select("task3.1/matvec", size_t(m) * n, space, [&](const autotune::Config& c) {
+            parallel(c.at("threads"));
+        }).at("threads");
+        std::cout << "threads = " << nt << std::endl;
     }
+
+    time_p = cpuSecond();
+    parallel(nt);
     time_p = cpuSecond() - time_p;
     time_s = cpuSecond();
     multiplyElements_sumple(arr1.get(), arr2.get(), result.get(), m, n );
@@ -0,0 +1,105 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <chrono>
+#include <cmath>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include "server.hpp"
+
+// Counts heap allocations on the submit / execute / collect path of
+// Server<double> in steady state, and the tasks per second it sustains.
+// Each scenario first runs `warm` tasks, so the slot pool, the scheduler
+// rings and the client's id vector reach their working size, then counts
+// operator new calls over the next `tasks` tasks. Exits with 1 if any
+// scenario allocates. usage: alloc_check [tasks] [warm]
+
+std::atomic<uint64_t> allocations{0};
+
+void* operator new(size_t n)
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(n ? n : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+    std::free(p);
+}
+
+// Same shape as task3.2: a client lambda capturing the (x, f(x)) pair,
+// results streamed out every `window` tasks.
+template <class Submit>
+double run(Server<double>& server, Client<double>& client, size_t tasks, size_t window, Submit submit, double& sum) {
+    auto start = std::chrono::steady_clock::now();
+    double x = 0.5;
+    for (size_t i = 0; i < tasks; i++)
+    {
+        x = x < 3.0 ? x + 1e-3 : 0.5;
+        submit(client, x);
+        if ((i + 1) % window == 0)
+            client.stream_res(server, [&](double, double r) { sum += r; });
+    }
+    client.stream_res(server, [&](double, double r) { sum += r; });
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+template <class Submit>
+bool scenario(const std::string& name, Server<double>& server, size_t tasks, size_t warm, Submit submit) {
+    Client<double> client;
+    double sum = 0.0;
+    run(server, client, warm, 1000, submit, sum);
+    uint64_t before = allocations.load();
+    double seconds = run(server, client, tasks, 1000, submit, sum);
+    uint64_t count = allocations.load() - before;
+    std::cout << std::left << std::setw(24) << name << std::right << std::setw(12) << count << std::setw(14)
+              << std::fixed << std::setprecision(4) << double(count) / tasks << std::setw(14) << std::setprecision(1)
+              << tasks / seconds / 1e3 << std::endl;
+    return count == 0;
+}
+
+int main(int argc, char const *argv[])
+{
+    size_t tasks = argc > 1 ? std::atol(argv[1]) : 1000000;
+    size_t warm = argc > 2 ? std::atol(argv[2]) : 10000;
+    std::cout << std::left << std::setw(24) << "scenario" << std::right << std::setw(12) << "allocations"
+              << std::setw(14) << "per task" << std::setw(14) << "ktasks/s" << std::endl;
+    bool ok = true;
+
+    Server<double> plain;
+    plain.set_limit(4096);
+    plain.start();
+    ok &= scenario("plain", plain, tasks, warm, [&](Client<double>& c, double x) {
+        c.run(plain, [x]() { return std::pair<double, double>(x, std::sin(x)); });
+    });
+    plain.stop();
+
+    Server<double> prioritized;
+    prioritized.start();
+    ok &= scenario("High + deadline", prioritized, tasks, warm, [&](Client<double>& c, double x) {
+        c.options.priority = Priority::High;
+        c.options.client = 7;
+        c.options.deadline = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+        c.run(prioritized, [x]() { return std::pair<double, double>(x, std::sin(x)); });
+    });
+    prioritized.stop();
+
+    Server<double> cached;
+    cached.enable_cache(4096);
+    cached.start();
+    ok &= scenario("keyed, cache", cached, tasks, warm, [&](Client<double>& c, double x) {
+        c.task_id.push_back({cached.add_task(0, x, [x]() { return std::sin(x); }), x});
+    });
+    cached.stop();
+
+    std::cout << (ok ? "steady state allocation-free" : "steady state allocates") << std::endl;
+    return ok ? 0 : 1;
+}
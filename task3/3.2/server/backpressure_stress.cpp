@@ -0,0 +1,159 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <chrono>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <fstream>
+#include <cstdlib>
+#include <unistd.h>
+#include <boost/program_options.hpp>
+#include "server.hpp"
+namespace opt = boost::program_options;
+
+// Sustained overload: producer threads submit as fast as they can while one
+// worker runs tasks of `cost` us, and a consumer per producer collects the
+// results in order as they come. Without a limit the queue, and the RSS,
+// grow for as long as the run lasts; with --limit the RSS levels off and the
+// overload shows up as blocked, rejected or timed-out submissions instead.
+
+using Clock = std::chrono::steady_clock;
+
+size_t rssKB() {
+    std::ifstream statm("/proc/self/statm");
+    size_t pages = 0, resident = 0;
+    statm >> pages >> resident;
+    return resident * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+double spin(double us) {
+    auto end = Clock::now() + std::chrono::duration<double, std::micro>(us);
+    double x = 0.0;
+    while (Clock::now() < end)
+        x += 1.0;
+    return x;
+}
+
+// ids handed from a producer to its consumer
+struct Channel {
+    std::mutex mut;
+    std::condition_variable cv;
+    std::deque<size_t> ids;
+    bool closed = false;
+};
+
+int main(int argc, char const *argv[])
+{
+    opt::options_description desc("Argument");
+    desc.add_options()
+        ("mode",opt::value<std::string>()->default_value("block"),"block, try or timeout submissions")
+        ("limit",opt::value<size_t>()->default_value(10000),"Pending task limit, 0 = unbounded")
+        ("producers",opt::value<int>()->default_value(2),"Producer threads")
+        ("cost",opt::value<double>()->default_value(10.0),"Work per task, us")
+        ("seconds",opt::value<double>()->default_value(4.0),"Run time")
+        ("timeout",opt::value<double>()->default_value(100.0),"add_task_for timeout, us")
+        ("help","help");
+    opt::variables_map vm;
+    opt::store(opt::parse_command_line(argc, argv, desc), vm);
+    opt::notify(vm);
+    if (vm.count("help")) {
+        std::cout << desc << "\n";
+        return 1;
+    }
+    std::string mode = vm["mode"].as<std::string>();
+    int producers = std::max(vm["producers"].as<int>(), 1);
+    double cost = vm["cost"].as<double>();
+    auto timeout = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double, std::micro>(vm["timeout"].as<double>()));
+    auto runFor = std::chrono::duration<double>(vm["seconds"].as<double>());
+
+    Server<double> server;
+    server.set_limit(vm["limit"].as<size_t>());
+    server.start();
+    std::vector<Channel> channels(producers);
+    std::atomic<bool> done{false};
+    std::atomic<uint64_t> submitted{0}, collected{0};
+    std::vector<std::thread> threads;
+    for (int p = 0; p < producers; p++)
+    {
+        threads.emplace_back([&, p]() {
+            Channel& ch = channels[p];
+            while (!done)
+            {
+                auto task = [cost]() { return spin(cost); };
+                size_t id = mode == "try" ? server.try_add_task(task)
+                          : mode == "timeout" ? server.add_task_for(task, timeout)
+                          : server.add_task(task);
+                if (id == 0)
+                {
+                    std::this_thread::yield();
+                    continue;
+                }
+                submitted++;
+                {
+                    std::lock_guard<std::mutex> lock(ch.mut);
+                    ch.ids.push_back(id);
+                }
+                ch.cv.notify_one();
+            }
+            {
+                std::lock_guard<std::mutex> lock(ch.mut);
+                ch.closed = true;
+            }
+            ch.cv.notify_one();
+        });
+        threads.emplace_back([&, p]() {
+            Channel& ch = channels[p];
+            while (true)
+            {
+                size_t id;
+                {
+                    std::unique_lock<std::mutex> lock(ch.mut);
+                    ch.cv.wait(lock, [&]() { return !ch.ids.empty() || ch.closed; });
+                    if (ch.ids.empty())
+                        break;
+                    id = ch.ids.front();
+                    ch.ids.pop_front();
+                }
+                server.request_result(id);
+                collected++;
+            }
+        });
+    }
+
+    std::cout << "mode " << mode << ", limit " << vm["limit"].as<size_t>() << ", " << producers << " producers, task "
+              << cost << " us" << std::endl;
+    std::cout << std::setw(6) << "t, s" << std::setw(10) << "RSS, MB" << std::setw(12) << "pending" << std::setw(12)
+              << "done/s" << std::endl;
+    auto start = Clock::now();
+    size_t peakRss = 0;
+    uint64_t lastCollected = 0;
+    auto last = start;
+    while (Clock::now() - start < runFor)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(500));
+        auto now = Clock::now();
+        size_t rss = rssKB();
+        peakRss = std::max(peakRss, rss);
+        uint64_t c = collected;
+        std::cout << std::fixed << std::setprecision(1) << std::setw(6) << std::chrono::duration<double>(now - start).count()
+                  << std::setw(10) << rss / 1024.0 << std::setw(12) << server.metrics().pending << std::setw(12)
+                  << long((c - lastCollected) / std::chrono::duration<double>(now - last).count()) << std::endl;
+        lastCollected = c;
+        last = now;
+    }
+    done = true;
+    auto m = server.metrics();
+    std::cout << "peak RSS " << peakRss / 1024.0 << " MB, peak pending " << m.peak_pending << ", submitted " << submitted
+              << ", blocked " << m.blocked << ", rejected " << m.rejected << ", timed out " << m.timed_out << std::endl;
+    // the backlog of an unbounded run takes far longer to drain than the run itself
+    if (vm["limit"].as<size_t>() == 0)
+        std::_Exit(0);
+    for (auto& t : threads)
+        t.join();
+    server.stop();
+    return 0;
+}
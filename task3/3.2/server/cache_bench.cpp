@@ -0,0 +1,139 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <thread>
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <algorithm>
+#include <boost/program_options.hpp>
+#include "server.hpp"
+namespace opt = boost::program_options;
+
+// The task3.2 workload (sin, sqrt, pow(x, 2) of random doubles) with the
+// function evaluated inside the task and arguments drawn with reuse: every
+// client draws from one shared pool of `distinct` arguments per function,
+// uniformly or Zipf-distributed, or fresh every time. The same task streams
+// run through the server without and with the result cache.
+
+enum Fn { Sin, Sqrt, Pow };
+
+double evaluate(int fn, double x) {
+    return fn == Sin ? std::sin(x) : fn == Sqrt ? std::sqrt(x) : std::pow(x, 2.0);
+}
+
+struct Draw {
+    int fn;
+    double x;
+};
+
+// Task stream of one client: fn cycles sin, sqrt, pow as in task3.2.
+std::vector<Draw> makeStream(const std::string& dist, int distinct, double s, size_t tasks, unsigned seed) {
+    std::mt19937_64 gen(42);
+    std::uniform_real_distribution<double> angle(-3.14159, 3.14159), positive(1.0, 10.0);
+    std::vector<double> pool[3];
+    for (int fn = 0; fn < 3; fn++)
+        for (int i = 0; i < distinct; i++)
+            pool[fn].push_back(fn == Sin ? angle(gen) : positive(gen));
+    gen.seed(seed);
+    // cumulative Zipf weights 1/rank^s
+    std::vector<double> cdf(distinct);
+    double sum = 0.0;
+    for (int i = 0; i < distinct; i++)
+        cdf[i] = sum += 1.0 / std::pow(i + 1.0, s);
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+    std::uniform_int_distribution<int> pick(0, distinct - 1);
+    std::vector<Draw> out(tasks);
+    for (size_t t = 0; t < tasks; t++)
+    {
+        int fn = t % 3;
+        double x;
+        if (dist == "fresh")
+            x = fn == Sin ? angle(gen) : positive(gen);
+        else if (dist == "zipf")
+            x = pool[fn][std::lower_bound(cdf.begin(), cdf.end(), unit(gen) * sum) - cdf.begin()];
+        else
+            x = pool[fn][pick(gen)];
+        out[t] = {fn, x};
+    }
+    return out;
+}
+
+// Seconds to submit every stream (one thread per client) and collect the results.
+double run(Server<double>& server, const std::vector<std::vector<Draw>>& streams, bool keyed, double& check) {
+    std::vector<double> sums(streams.size(), 0.0);
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> clients;
+    for (size_t c = 0; c < streams.size(); c++)
+        clients.emplace_back([&, c]() {
+            std::vector<size_t> ids;
+            ids.reserve(streams[c].size());
+            for (const Draw& d : streams[c])
+            {
+                auto task = [d]() { return evaluate(d.fn, d.x); };
+                ids.push_back(keyed ? server.add_task(d.fn, d.x, task) : server.add_task(task));
+            }
+            for (size_t id : ids)
+                sums[c] += server.request_result(id);
+        });
+    for (auto& t : clients)
+        t.join();
+    std::chrono::duration<double> d = std::chrono::steady_clock::now() - start;
+    check = 0.0;
+    for (double s : sums)
+        check += s;
+    return d.count();
+}
+
+int main(int argc, char const *argv[])
+{
+    opt::options_description desc("Argument");
+    desc.add_options()
+        ("tasks",opt::value<size_t>()->default_value(300000),"Tasks per client")
+        ("clients",opt::value<int>()->default_value(3),"Submitting threads")
+        ("workers",opt::value<int>()->default_value(1),"Server threads")
+        ("dist",opt::value<std::string>()->default_value("zipf"),"Argument reuse: uniform, zipf or fresh")
+        ("distinct",opt::value<int>()->default_value(10000),"Distinct arguments per function")
+        ("zipf",opt::value<double>()->default_value(1.0),"Zipf exponent")
+        ("capacity",opt::value<size_t>()->default_value(8192),"Cache entries")
+        ("shards",opt::value<int>()->default_value(16),"Cache shards")
+        ("help","help");
+    opt::variables_map vm;
+    opt::store(opt::parse_command_line(argc, argv, desc), vm);
+    opt::notify(vm);
+    if (vm.count("help")) {
+        std::cout << desc << "\n";
+        return 1;
+    }
+    int clients = std::max(vm["clients"].as<int>(), 1);
+    size_t tasks = vm["tasks"].as<size_t>();
+    std::string dist = vm["dist"].as<std::string>();
+    std::vector<std::vector<Draw>> streams;
+    for (int c = 0; c < clients; c++)
+        streams.push_back(makeStream(dist, std::max(vm["distinct"].as<int>(), 1), vm["zipf"].as<double>(), tasks, 1 + c));
+
+    double plainSum, cachedSum;
+    Server<double> plain(vm["workers"].as<int>());
+    plain.start();
+    double tPlain = run(plain, streams, false, plainSum);
+    plain.stop();
+
+    Server<double> cached(vm["workers"].as<int>());
+    cached.enable_cache(vm["capacity"].as<size_t>(), vm["shards"].as<int>());
+    cached.start();
+    double tCached = run(cached, streams, true, cachedSum);
+    cached.stop();
+    ResultCache<double>& rc = *cached.result_cache();
+
+    double n = double(tasks) * clients;
+    std::cout << std::fixed << std::setprecision(3);
+    std::cout << "tasks " << size_t(n) << ", dist " << dist << ", capacity " << vm["capacity"].as<size_t>() << std::endl;
+    std::cout << "no cache:   " << std::setw(10) << n / tPlain / 1e3 << " ktasks/s" << std::endl;
+    std::cout << "cache:      " << std::setw(10) << n / tCached / 1e3 << " ktasks/s  (x" << tPlain / tCached << ")" << std::endl;
+    std::cout << "hits " << rc.hits << ", misses " << rc.misses << ", hit rate " << 100.0 * rc.hits / n
+              << "%, evictions " << rc.evictions << ", entries " << rc.size() << std::endl;
+    if (plainSum != cachedSum)
+        std::cout << "result mismatch: " << plainSum << " vs " << cachedSum << std::endl;
+    return 0;
+}
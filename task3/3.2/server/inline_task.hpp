@@ -0,0 +1,62 @@
+#pragma once
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+// A callable returning R, stored in place. The object lives in its Server
+// slot from submission until it has run, so it is never copied or moved:
+// emplace constructs the callable in the buffer, reset destroys it.
+// A callable larger than Size bytes (or over-aligned) still works but is
+// kept on the heap, the one case where a submission allocates.
+template <class R, size_t Size = 64>
+class InlineTask {
+private:
+    alignas(std::max_align_t) unsigned char buf[Size];
+    R (*call)(void*) = nullptr;
+    void (*destroy)(void*) = nullptr;
+
+    template <class F>
+    static constexpr bool fits = sizeof(F) <= Size && alignof(F) <= alignof(std::max_align_t);
+
+public:
+    InlineTask() = default;
+    InlineTask(const InlineTask&) = delete;
+    InlineTask& operator=(const InlineTask&) = delete;
+    ~InlineTask() {
+        reset();
+    }
+
+    template <class F>
+    void emplace(F&& f) {
+        using Fn = typename std::decay<F>::type;
+        reset();
+        if constexpr (fits<Fn>)
+        {
+            new (buf) Fn(std::forward<F>(f));
+            call = [](void* p) -> R { return (*static_cast<Fn*>(p))(); };
+            destroy = [](void* p) { static_cast<Fn*>(p)->~Fn(); };
+        }
+        else
+        {
+            *reinterpret_cast<Fn**>(buf) = new Fn(std::forward<F>(f));
+            call = [](void* p) -> R { return (**static_cast<Fn**>(p))(); };
+            destroy = [](void* p) { delete *static_cast<Fn**>(p); };
+        }
+    }
+
+    R operator()() {
+        return call(buf);
+    }
+
+    explicit operator bool() const {
+        return call != nullptr;
+    }
+
+    void reset() {
+        if (destroy)
+            destroy(buf);
+        call = nullptr;
+        destroy = nullptr;
+    }
+};
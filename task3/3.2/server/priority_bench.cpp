@@ -0,0 +1,140 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <thread>
+#include <chrono>
+#include <atomic>
+#include <algorithm>
+#include <boost/program_options.hpp>
+#include "server.hpp"
+namespace opt = boost::program_options;
+
+// Mixed load on one Server<double>: a bulk client keeps `burst` tasks queued
+// at all times while an interactive client submits one task at a time and
+// waits for it. Reported is the interactive latency, first with every task
+// in submission order (the old server), then with the interactive tasks in
+// the High class with a deadline and the bulk ones in the Bulk class.
+// A last run checks the fair share of two bulk clients with weights 3 and 1.
+
+using Clock = std::chrono::steady_clock;
+
+// about `us` microseconds of work
+double spin(double us) {
+    auto end = Clock::now() + std::chrono::duration<double, std::micro>(us);
+    double x = 0.0;
+    while (Clock::now() < end)
+        x += 1.0;
+    return x;
+}
+
+double percentile(std::vector<double> v, double p) {
+    std::sort(v.begin(), v.end());
+    return v[std::min(v.size() - 1, size_t(p * (v.size() - 1) + 0.5))];
+}
+
+void mixed(bool prioritized, int burst, double cost, int probes, double gapUs, double budgetUs) {
+    Server<double> server;
+    server.start();
+    std::atomic<bool> done{false};
+    std::atomic<long> bulkDone{0};
+    TaskOptions bulk, interactive;
+    if (prioritized)
+    {
+        bulk.priority = Priority::Bulk;
+        bulk.client = 1;
+        interactive.priority = Priority::High;
+        interactive.client = 2;
+    }
+    std::thread producer([&]() {
+        std::vector<size_t> ids;
+        while (!done)
+        {
+            for (int i = 0; i < burst; i++)
+                ids.push_back(server.add_task([cost]() { return spin(cost); }, bulk));
+            // keep one burst queued behind the one being collected
+            size_t half = ids.size() > size_t(burst) ? ids.size() - burst : 0;
+            for (size_t i = 0; i < half; i++)
+                server.request_result(ids[i]);
+            bulkDone += half;
+            ids.erase(ids.begin(), ids.begin() + half);
+        }
+        for (size_t id : ids)
+            server.request_result(id);
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    std::vector<double> latency;
+    auto start = Clock::now();
+    for (int p = 0; p < probes; p++)
+    {
+        auto t0 = Clock::now();
+        if (prioritized)
+            interactive.deadline = t0 + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double, std::micro>(budgetUs));
+        server.request_result(server.add_task([cost]() { return spin(cost); }, interactive));
+        latency.push_back(std::chrono::duration<double, std::milli>(Clock::now() - t0).count());
+        std::this_thread::sleep_for(std::chrono::duration<double, std::micro>(gapUs));
+    }
+    std::chrono::duration<double> elapsed = Clock::now() - start;
+    long bulkRate = long(bulkDone / elapsed.count());
+    done = true;
+    producer.join();
+    server.stop();
+    std::cout << std::left << std::setw(12) << (prioritized ? "priorities" : "fifo") << std::right << std::fixed
+              << std::setprecision(3) << std::setw(10) << percentile(latency, 0.5) << std::setw(10)
+              << percentile(latency, 0.99) << std::setw(10) << percentile(latency, 1.0) << std::setw(12) << bulkRate
+              << std::setw(10) << server.deadline_misses << std::endl;
+}
+
+void fairShare(int tasks, double cost) {
+    Server<double> server;
+    std::atomic<long> order{0};
+    TaskOptions a, b;
+    a.client = 1;
+    a.weight = 3.0;
+    b.client = 2;
+    b.weight = 1.0;
+    std::vector<size_t> ida, idb;
+    for (int i = 0; i < tasks; i++)
+    {
+        ida.push_back(server.add_task([&, cost]() { spin(cost); return double(order++); }, a));
+        idb.push_back(server.add_task([&, cost]() { spin(cost); return double(order++); }, b));
+    }
+    server.start();
+    int firstHalfA = 0;
+    for (size_t id : ida)
+        firstHalfA += server.request_result(id) < tasks;
+    for (size_t id : idb)
+        server.request_result(id);
+    server.stop();
+    std::cout << "weights 3:1, share of client A in the first " << tasks << " tasks: " << std::setprecision(1)
+              << 100.0 * firstHalfA / tasks << "% (expected 75%)" << std::endl;
+}
+
+int main(int argc, char const *argv[])
+{
+    opt::options_description desc("Argument");
+    desc.add_options()
+        ("burst",opt::value<int>()->default_value(2000),"Bulk tasks kept queued")
+        ("cost",opt::value<double>()->default_value(20.0),"Work per task, us")
+        ("probes",opt::value<int>()->default_value(300),"Interactive tasks")
+        ("gap",opt::value<double>()->default_value(2000.0),"Pause between interactive tasks, us")
+        ("budget",opt::value<double>()->default_value(1000.0),"Interactive deadline, us after submission")
+        ("help","help");
+    opt::variables_map vm;
+    opt::store(opt::parse_command_line(argc, argv, desc), vm);
+    opt::notify(vm);
+    if (vm.count("help")) {
+        std::cout << desc << "\n";
+        return 1;
+    }
+    int burst = vm["burst"].as<int>();
+    double cost = vm["cost"].as<double>();
+    std::cout << "bulk burst " << burst << ", task " << cost << " us, interactive every " << vm["gap"].as<double>()
+              << " us" << std::endl;
+    std::cout << std::left << std::setw(12) << "scheduling" << std::right << std::setw(10) << "p50 ms" << std::setw(10)
+              << "p99 ms" << std::setw(10) << "max ms" << std::setw(12) << "bulk/s" << std::setw(10) << "missed" << std::endl;
+    for (bool prioritized : {false, true})
+        mixed(prioritized, burst, cost, vm["probes"].as<int>(), vm["gap"].as<double>(), vm["budget"].as<double>());
+    fairShare(burst, cost);
+    return 0;
+}
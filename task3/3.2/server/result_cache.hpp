@@ -0,0 +1,179 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <vector>
+#include <type_traits>
+
+// Bounded result cache for pure tasks, keyed by (function id, argument bits).
+// The entries are split over shards by key hash, each shard a mutex and a
+// CLOCK ring: a hit sets the entry's reference bit, an insert into a full
+// shard advances the hand, clearing bits, until it finds an entry whose bit
+// is clear and replaces it. Hits therefore only take the shard lock; no list
+// is relinked on every hit as LRU would. The index of a shard is an
+// open-addressed table of slot numbers (linear probing, at most half full),
+// so neither a hit nor an eviction allocates.
+
+struct CacheKey {
+    uint64_t fn;
+    uint64_t bits;
+
+    // An argument of up to 8 bytes by value: -0.0 and 0.0 are different keys,
+    // as are NaNs with different payloads.
+    template <class A>
+    static CacheKey of(uint64_t fn, const A& arg) {
+        static_assert(std::is_trivially_copyable<A>::value && sizeof(A) <= sizeof(uint64_t),
+                      "cache key argument must be a trivially copyable value of up to 8 bytes");
+        CacheKey k{fn, 0};
+        std::memcpy(&k.bits, &arg, sizeof(A));
+        return k;
+    }
+
+    bool operator==(const CacheKey& o) const {
+        return fn == o.fn && bits == o.bits;
+    }
+};
+
+struct CacheKeyHash {
+    size_t operator()(const CacheKey& k) const {
+        // splitmix64 finaliser over both words
+        uint64_t x = k.bits ^ (k.fn * 0x9e3779b97f4a7c15ull);
+        x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+        x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+        return size_t(x ^ (x >> 31));
+    }
+};
+
+template <class T>
+class ResultCache {
+private:
+    struct Slot {
+        CacheKey key;
+        T value;
+        bool referenced;
+    };
+    static constexpr uint32_t Empty = ~0u;
+    struct Shard {
+        std::mutex mut;
+        std::vector<Slot> slots;
+        std::vector<uint32_t> index;    // slot number or Empty
+        size_t mask = 0;
+        size_t capacity = 0;
+        size_t hand = 0;
+
+        // position in index of key, or of the empty entry ending its probe run
+        size_t probe(const CacheKey& key, size_t hash) const {
+            size_t i = hash & mask;
+            while (index[i] != Empty && !(slots[index[i]].key == key))
+                i = (i + 1) & mask;
+            return i;
+        }
+
+        // backward-shift deletion keeps every probe run unbroken
+        void erase(size_t i) {
+            size_t j = i;
+            while (true)
+            {
+                j = (j + 1) & mask;
+                if (index[j] == Empty)
+                    break;
+                size_t home = CacheKeyHash()(slots[index[j]].key) & mask;
+                if (((j - home) & mask) >= ((j - i) & mask))
+                {
+                    index[i] = index[j];
+                    i = j;
+                }
+            }
+            index[i] = Empty;
+        }
+    };
+    std::vector<Shard> shards;
+
+public:
+    std::atomic<uint64_t> hits{0};
+    std::atomic<uint64_t> misses{0};
+    std::atomic<uint64_t> evictions{0};
+
+    // capacity entries in total, at least one per shard
+    explicit ResultCache(size_t capacity, int shardCount = 16) : shards(shardCount < 1 ? 1 : shardCount) {
+        for (size_t s = 0; s < shards.size(); s++)
+        {
+            Shard& sh = shards[s];
+            sh.capacity = capacity / shards.size() + (s < capacity % shards.size() ? 1 : 0);
+            if (sh.capacity == 0)
+                sh.capacity = 1;
+            size_t tableSize = 1;
+            while (tableSize < 2 * sh.capacity)
+                tableSize *= 2;
+            sh.slots.reserve(sh.capacity);
+            sh.index.assign(tableSize, Empty);
+            sh.mask = tableSize - 1;
+        }
+    }
+
+    bool find(const CacheKey& key, T& value) {
+        size_t hash = CacheKeyHash()(key);
+        Shard& sh = shardOf(hash);
+        {
+            std::lock_guard<std::mutex> lock(sh.mut);
+            size_t i = sh.probe(key, hash);
+            if (sh.index[i] != Empty)
+            {
+                Slot& slot = sh.slots[sh.index[i]];
+                slot.referenced = true;
+                value = slot.value;
+                hits++;
+                return true;
+            }
+        }
+        misses++;
+        return false;
+    }
+
+    void insert(const CacheKey& key, const T& value) {
+        size_t hash = CacheKeyHash()(key);
+        Shard& sh = shardOf(hash);
+        std::lock_guard<std::mutex> lock(sh.mut);
+        size_t i = sh.probe(key, hash);
+        if (sh.index[i] != Empty)
+        {
+            // computed twice while in flight; same value for a pure task
+            sh.slots[sh.index[i]].value = value;
+            return;
+        }
+        if (sh.slots.size() < sh.capacity)
+        {
+            sh.index[i] = uint32_t(sh.slots.size());
+            sh.slots.push_back({key, value, false});
+            return;
+        }
+        while (sh.slots[sh.hand].referenced)
+        {
+            sh.slots[sh.hand].referenced = false;
+            sh.hand = (sh.hand + 1) % sh.capacity;
+        }
+        Slot& victim = sh.slots[sh.hand];
+        sh.erase(sh.probe(victim.key, CacheKeyHash()(victim.key)));
+        sh.index[sh.probe(key, hash)] = uint32_t(sh.hand);
+        victim = {key, value, false};
+        sh.hand = (sh.hand + 1) % sh.capacity;
+        evictions++;
+    }
+
+    size_t size() {
+        size_t n = 0;
+        for (Shard& sh : shards)
+        {
+            std::lock_guard<std::mutex> lock(sh.mut);
+            n += sh.slots.size();
+        }
+        return n;
+    }
+
+private:
+    // high bits pick the shard, low bits the position in its index
+    Shard& shardOf(size_t hash) {
+        return shards[(hash >> 48) % shards.size()];
+    }
+};
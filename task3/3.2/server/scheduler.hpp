@@ -0,0 +1,181 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// Run order of the queued Server<T> tasks.
+//
+// Priority classes are strict: a High task always runs before a Normal one,
+// Normal before Bulk. Inside a class, tasks with a deadline go first, earliest
+// deadline first. The rest are shared between clients by weighted fair
+// queuing: every client has a virtual finish time that advances by 1/weight
+// per task, and the task with the smallest finish time runs next. With one
+// client and no deadlines that is submission order, the old behaviour.
+//
+// The scheduler is not locked itself; Server<T> guards it with the queue
+// mutex, held only for the O(log n) push and pop. Its containers only grow,
+// so once they have reached the peak queue length push and pop do not allocate.
+
+enum class Priority { High = 0, Normal = 1, Bulk = 2 };
+
+using Deadline = std::chrono::steady_clock::time_point;
+constexpr Deadline NoDeadline = Deadline::max();
+
+struct TaskOptions {
+    Priority priority = Priority::Normal;
+    int client = 0;
+    double weight = 1.0;            // fair share of `client` within its class
+    Deadline deadline = NoDeadline;
+};
+
+// FIFO on a power-of-two ring that doubles when full and never shrinks.
+template <class V>
+class Ring {
+private:
+    std::vector<V> buf;
+    size_t head = 0;
+    size_t n = 0;
+public:
+    void push_back(V v) {
+        if (n == buf.size())
+        {
+            std::vector<V> bigger(std::max<size_t>(8, 2 * buf.size()));
+            for (size_t i = 0; i < n; i++)
+                bigger[i] = std::move(buf[(head + i) & (buf.size() - 1)]);
+            buf.swap(bigger);
+            head = 0;
+        }
+        buf[(head + n) & (buf.size() - 1)] = std::move(v);
+        n++;
+    }
+    V& front() {
+        return buf[head];
+    }
+    void pop_front() {
+        head = (head + 1) & (buf.size() - 1);
+        n--;
+    }
+    bool empty() const {
+        return n == 0;
+    }
+    size_t size() const {
+        return n;
+    }
+};
+
+template <class Task>
+class Scheduler {
+private:
+    struct Entry {
+        Deadline deadline;
+        double start;
+        double finish;
+        uint64_t seq;
+        Task task;
+    };
+    struct EarlierDeadline {
+        bool operator()(const Entry& a, const Entry& b) const {
+            return a.deadline > b.deadline || (a.deadline == b.deadline && a.seq > b.seq);
+        }
+    };
+    // A client's tasks in submission order; only clients with queued tasks
+    // are in the heap, keyed by the finish time of their first task.
+    struct Flow {
+        Ring<Entry> queue;
+        double lastFinish = 0.0;
+    };
+    struct Active {
+        double finish;
+        uint64_t seq;
+        Flow* flow;
+        bool operator<(const Active& o) const {
+            return finish > o.finish || (finish == o.finish && seq > o.seq);
+        }
+    };
+    struct Class {
+        std::vector<Entry> edf;     // heap
+        std::vector<Active> active; // heap
+        std::unordered_map<int, Flow> flows;
+        int lastClient = 0;
+        Flow* lastFlow = nullptr;
+        double vtime = 0.0;
+
+        Flow& flow(int client) {
+            if (!lastFlow || lastClient != client)
+            {
+                lastFlow = &flows[client];  // node-based map, the pointer stays valid
+                lastClient = client;
+            }
+            return *lastFlow;
+        }
+    };
+    static constexpr int Classes = 3;
+    Class classes[Classes];
+    uint64_t seq = 0;
+    size_t count = 0;
+
+public:
+    void push(Task task, const TaskOptions& o) {
+        Class& c = classes[std::min(std::max(int(o.priority), 0), Classes - 1)];
+        Entry e{o.deadline, 0.0, 0.0, seq++, std::move(task)};
+        count++;
+        if (o.deadline != NoDeadline)
+        {
+            c.edf.push_back(std::move(e));
+            std::push_heap(c.edf.begin(), c.edf.end(), EarlierDeadline());
+            return;
+        }
+        Flow& f = c.flow(o.client);
+        e.start = std::max(c.vtime, f.lastFinish);
+        e.finish = f.lastFinish = e.start + 1.0 / (o.weight > 0.0 ? o.weight : 1.0);
+        f.queue.push_back(std::move(e));
+        if (f.queue.size() == 1)
+        {
+            c.active.push_back({f.queue.front().finish, f.queue.front().seq, &f});
+            std::push_heap(c.active.begin(), c.active.end());
+        }
+    }
+
+    bool empty() const {
+        return count == 0;
+    }
+
+    size_t size() const {
+        return count;
+    }
+
+    // The next task to run; the scheduler must not be empty.
+    Task pop() {
+        for (Class& c : classes)
+        {
+            if (!c.edf.empty())
+            {
+                std::pop_heap(c.edf.begin(), c.edf.end(), EarlierDeadline());
+                Task t = std::move(c.edf.back().task);
+                c.edf.pop_back();
+                count--;
+                return t;
+            }
+            if (!c.active.empty())
+            {
+                std::pop_heap(c.active.begin(), c.active.end());
+                Flow& f = *c.active.back().flow;
+                c.active.pop_back();
+                // start-time fair queuing: an idle client rejoins at the current virtual time
+                c.vtime = f.queue.front().start;
+                Task t = std::move(f.queue.front().task);
+                f.queue.pop_front();
+                if (!f.queue.empty())
+                {
+                    c.active.push_back({f.queue.front().finish, f.queue.front().seq, &f});
+                    std::push_heap(c.active.begin(), c.active.end());
+                }
+                count--;
+                return t;
+            }
+        }
+        return Task();
+    }
+};
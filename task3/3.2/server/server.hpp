@@ -0,0 +1,349 @@
+#pragma once
+#include <iostream>
+#include <list>
+#include <vector>
+#include <thread>
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+#include <memory>
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include "inline_task.hpp"
+#include "result_cache.hpp"
+#include "scheduler.hpp"
+
+// Task server of task3.2: add_task queues a call and returns its id,
+// request_result blocks until that task has run and hands over the result.
+// The tasks run on `workers` server threads (one by default); a task runs
+// outside the lock, so a long task does not hold up submissions or results.
+//
+// Every pending task owns a slot: the callable is constructed in it as an
+// InlineTask, the worker writes the result into it, request_result moves the
+// result out and returns the slot to the free list. Slots come in chunks that
+// are kept for the life of the server, so once the pool has grown to the peak
+// number of pending tasks (or was sized by set_limit) submitting, running and
+// collecting a task allocate nothing. An id is the slot number plus the
+// slot's generation, so ids stay unique while slots are reused.
+//
+// With enable_cache, tasks submitted with a key (function id, argument) are
+// looked up in a ResultCache first: a hit is stored as the task's result right
+// away and never queued, a miss is queued and its result cached once it runs.
+// Only pure tasks may be keyed; two misses on the same key in flight both run.
+//
+// The queue is a Scheduler (priority classes, deadlines, per-client fair
+// share) with its own mutex; the results have another, so submitting does
+// not wake the threads waiting for results and vice versa.
+//
+// set_limit bounds the pending tasks: submitted and not yet collected by
+// request_result, whether still queued, running or holding a result. At the
+// limit add_task waits for a slot, try_add_task gives up at once and
+// add_task_for after a timeout (both return id 0 then), so memory stays
+// bounded however fast the producers are, provided the results are read.
+
+template <typename T>
+
+class Server{
+    private:
+    struct Slot {
+        InlineTask<T> task;
+        T result{};
+        bool ready = false;         // result written, guarded by mut
+        bool keyed = false;
+        CacheKey key{0, 0};
+        Deadline deadline = NoDeadline;
+        uint32_t generation = 0;
+    };
+    static constexpr size_t ChunkSize = 1024;
+    static constexpr size_t MaxChunks = 65536;
+
+    std::vector<std::thread> threads_of_server;
+    std::mutex mut;
+    std::condition_variable cv;
+    std::mutex queue_mut;
+    std::condition_variable queue_cv;
+    Scheduler<uint32_t> tasks;
+    std::unique_ptr<std::unique_ptr<Slot[]>[]> chunks;
+    size_t chunk_count = 0;
+    std::vector<uint32_t> free_slots;
+    std::unique_ptr<ResultCache<T>> cache;
+    bool flag = true;
+    int workers;
+    size_t limit = 0;
+    std::atomic<size_t> pending{0};
+    std::condition_variable space_cv;
+    public:
+    // tasks that started after their deadline
+    std::atomic<uint64_t> deadline_misses{0};
+
+    struct Metrics {
+        size_t pending;
+        size_t peak_pending;        // high-water mark of submitted, uncollected tasks
+        uint64_t blocked;           // submissions that had to wait for a slot
+        uint64_t rejected;          // try_add_task at the limit
+        uint64_t timed_out;         // add_task_for that gave up
+        size_t slots;               // size of the slot pool
+    };
+
+explicit Server(int workers = 1)
+    : chunks(new std::unique_ptr<Slot[]>[MaxChunks]), workers(workers < 1 ? 1 : workers) {}
+
+// Call before start(); capacity is the number of cached results.
+void enable_cache(size_t capacity, int shards = 16)
+{
+    cache.reset(new ResultCache<T>(capacity, shards));
+}
+
+// nullptr when the cache is off; holds the hit/miss counters
+ResultCache<T>* result_cache()
+{
+    return cache.get();
+}
+
+// Call before start(); 0 (the default) leaves the server unbounded.
+// A limit also preallocates that many slots.
+void set_limit(size_t max_pending)
+{
+    limit = max_pending;
+    std::unique_lock<std::mutex> lock_queue(queue_mut);
+    while (chunk_count * ChunkSize < limit)
+        add_chunk();
+}
+
+Metrics metrics()
+{
+    std::unique_lock<std::mutex> lock_queue(queue_mut);
+    return {pending.load(), peak_pending, blocked, rejected, timed_out, chunk_count * ChunkSize};
+}
+
+void start()
+{
+    flag = false;
+    for (int i = 0; i < workers; i++)
+        threads_of_server.emplace_back(&Server::server_thread, this);
+    std::cout<< "server start" << std::endl;
+}
+
+void stop()
+{
+    {std::unique_lock<std::mutex> lock_queue(queue_mut);
+    flag = true;
+    queue_cv.notify_all();
+    }
+    for (auto& t : threads_of_server)
+        t.join();
+    threads_of_server.clear();
+}
+
+// Throws std::invalid_argument for 0 (the "not submitted" id), an id that
+// was never handed out, or one whose result was already collected.
+T request_result(size_t id_res)
+{
+    uint32_t low = uint32_t(id_res);
+    uint32_t index = low - 1;
+    {
+        std::unique_lock<std::mutex> lock_queue(queue_mut);
+        if (low == 0 || index >= chunk_count * ChunkSize || slot(index).generation != uint32_t(id_res >> 32))
+            throw std::invalid_argument("Server: unknown or already collected task id");
+    }
+    Slot& s = slot(index);
+    std::unique_lock<std::mutex> lock_res(mut);
+    cv.wait(lock_res, [&s]() {return s.ready;});
+    T result = std::move(s.result);
+    s.ready = false;
+    lock_res.unlock();
+    release(index);
+    return result;
+}
+
+void server_thread()
+{
+
+    while (true)
+{
+        std::unique_lock<std::mutex> lock_queue(queue_mut);
+        queue_cv.wait(lock_queue, [this]() {return !tasks.empty() || flag;});
+        if (tasks.empty() && flag)
+            break;
+        if (!tasks.empty())
+        {
+            Slot& s = slot(tasks.pop());
+            lock_queue.unlock();
+            if (s.deadline != NoDeadline && std::chrono::steady_clock::now() > s.deadline)
+                deadline_misses++;
+            T result = s.task();
+            s.task.reset();
+            if (s.keyed)
+                cache->insert(s.key, result);
+            std::unique_lock<std::mutex> lock_res(mut);
+            s.result = std::move(result);
+            s.ready = true;
+            cv.notify_all();
+        }
+    }
+
+    std::cout << "Server stop!\n";
+}
+
+template <class F>
+size_t add_task(F&& task, const TaskOptions& options = TaskOptions())
+{
+    return submit(std::forward<F>(task), options, Wait::Block, Clock::time_point(), nullptr);
+}
+
+// 0 when the server is at its limit
+template <class F>
+size_t try_add_task(F&& task, const TaskOptions& options = TaskOptions())
+{
+    return submit(std::forward<F>(task), options, Wait::Try, Clock::time_point(), nullptr);
+}
+
+// 0 when no slot frees up within timeout
+template <class F, class Rep, class Period>
+size_t add_task_for(F&& task, std::chrono::duration<Rep, Period> timeout, const TaskOptions& options = TaskOptions())
+{
+    return submit(std::forward<F>(task), options, Wait::Until,
+                  Clock::now() + std::chrono::duration_cast<Clock::duration>(timeout), nullptr);
+}
+
+// A pure task: fn identifies the function, arg is its only input.
+template <class A, class F>
+size_t add_task(uint64_t fn, const A& arg, F&& task, const TaskOptions& options = TaskOptions())
+{
+    CacheKey key = CacheKey::of(fn, arg);
+    return submit(std::forward<F>(task), options, Wait::Block, Clock::time_point(), &key);
+}
+
+private:
+using Clock = std::chrono::steady_clock;
+enum class Wait { Block, Try, Until };
+size_t peak_pending = 0;
+uint64_t blocked = 0, rejected = 0, timed_out = 0;
+
+Slot& slot(uint32_t index)
+{
+    return chunks[index / ChunkSize][index % ChunkSize];
+}
+
+// with queue_mut held; slots are numbered so the lowest come off the free list first
+void add_chunk()
+{
+    if (chunk_count == MaxChunks)
+        throw std::length_error("Server: slot pool exhausted");
+    chunks[chunk_count].reset(new Slot[ChunkSize]);
+    free_slots.reserve((chunk_count + 1) * ChunkSize);
+    for (size_t i = ChunkSize; i-- > 0;)
+        free_slots.push_back(uint32_t(chunk_count * ChunkSize + i));
+    chunk_count++;
+}
+
+size_t submit_id(uint32_t index)
+{
+    return (size_t(slot(index).generation) << 32) | (index + 1);
+}
+
+template <class F>
+size_t submit(F&& task, const TaskOptions& options, Wait wait, Clock::time_point until, const CacheKey* key)
+{
+    T value;
+    bool hit = key && cache && cache->find(*key, value);
+
+    // блокировщик для работы с общими данными
+    std::unique_lock<std::mutex> lock_queue(queue_mut);
+    if (limit && pending.load() >= limit)
+    {
+        if (wait == Wait::Try)
+        {
+            rejected++;
+            return 0;
+        }
+        blocked++;
+        auto hasSpace = [this]() { return pending.load() < limit; };
+        if (wait == Wait::Block)
+            space_cv.wait(lock_queue, hasSpace);
+        else if (!space_cv.wait_until(lock_queue, until, hasSpace))
+        {
+            timed_out++;
+            return 0;
+        }
+    }
+    size_t now = ++pending;
+    if (now > peak_pending)
+        peak_pending = now;
+    if (free_slots.empty())
+        add_chunk();
+    uint32_t index = free_slots.back();
+    free_slots.pop_back();
+    Slot& s = slot(index);
+
+    // id задачи
+    size_t id_task = submit_id(index);
+    if (hit)
+    {
+        lock_queue.unlock();
+        std::unique_lock<std::mutex> lock_res(mut);
+        s.result = std::move(value);
+        s.ready = true;
+        cv.notify_all();
+        return id_task;
+    }
+
+    // создаем задачу прямо в слоте
+    s.task.emplace(std::forward<F>(task));
+    s.keyed = key && cache;
+    if (s.keyed)
+        s.key = *key;
+    s.deadline = options.deadline;
+    tasks.push(index, options);
+    queue_cv.notify_one();
+    return id_task;
+}
+
+void release(uint32_t index)
+{
+    std::unique_lock<std::mutex> lock_queue(queue_mut);
+    slot(index).generation++;
+    free_slots.push_back(index);
+    pending--;
+    if (limit)
+        space_cv.notify_one();
+}
+
+};
+
+template<typename T>
+
+class Client {
+    public:
+        // how the tasks of this client are scheduled; options.client names its fair-share flow
+        TaskOptions options;
+        std::vector<std::pair<size_t, T>> task_id;
+        std::list<std::pair<T,T>> client_res (Server <T>& server)
+        {
+            std::list<std::pair<T,T>> results;
+            for (const auto& pair : task_id)
+            {
+                T result = server.request_result(pair.first);
+                results.push_back({pair.second, result});
+            }
+            return results;
+        }
+        // Hands over the results collected so far in submission order and
+        // forgets their ids, so a long-running client keeps O(batch) state.
+        template <class Sink>
+        void stream_res (Server <T>& server, Sink sink)
+        {
+            for (const auto& pair : task_id)
+                sink(pair.second, server.request_result(pair.first));
+            task_id.clear();
+        }
+        template <class Gen>
+        void run (Server<T>& server, Gen gen_task)
+        {
+            auto task = gen_task();
+            size_t id = server.add_task([task]() {return task.second; }, options);
+            task_id.push_back({id, task.first});
+        }
+
+};
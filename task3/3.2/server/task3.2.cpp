@@ -8,174 +8,81 @@
 #include <cmath>
 #include <functional>
 #include <mutex>
-#include <random>
 #include <condition_variable>
+#include "server.hpp"
+#include "../../../common/philox.hpp"
 
-template <typename T>
-
-class Server{
-    private:
-    std::thread thread_of_server;
-    std::mutex mut;
-    std::queue<std::pair<size_t, std::future<T>>> tasks;
-    std::unordered_map<size_t, T> results;
-    std::condition_variable cv;
-    size_t id = 1;
-    bool flag = true;
-    public: 
-
-
-void start()
-{
-    flag = false;
-    thread_of_server = std::thread(&Server::server_thread, this);
-    std::cout<< "server start" << std::endl;
-}
-
-void stop()
-{
-    {std::unique_lock<std::mutex> lock_res(mut);
-    flag = true;
-    cv.notify_one();
-    }
-    thread_of_server.join();
-}
-
-T request_result(size_t id_res)
-{
-    std::unique_lock<std::mutex> lock_res(mut);
-    cv.wait(lock_res, [this, id_res]() {return results.find(id_res) != results.end();});
-    T result = results[id_res];
-    results.erase(id_res);
-    return result;
-}
-
-void server_thread()
-{
-    
-    while (true)
-{
-        std::unique_lock<std::mutex> lock_res(mut);
-        size_t id_task;
-        cv.wait(lock_res, [this]() {return !tasks.empty() || flag;});
-        if (tasks.empty() && flag)
-            break;
-        if (!tasks.empty())
-        {
-            auto task = std::move(tasks.front());
-            tasks.pop();
-            results[task.first] = task.second.get();
-            cv.notify_one();
-        }
-    }
-
-    std::cout << "Server stop!\n";
-}
-
-size_t add_task(std::function<T()> task)
-{
-    // id задачи
-    size_t id_task = id;
-    id++;
-
-    // блокировщик для работы с общими данными
-    std::unique_lock<std::mutex> lock_res(mut);
-
-    // создаем задачу (ленивое выполнение)
-    tasks.push({id_task, std::async(std::launch::deferred, task)});
-    cv.notify_one();
-    return tasks.back().first;
-}
-
-};
-
-template<typename T>
-
-class Client {
-    public:
-        std::vector<std::pair<int, T>> task_id;
-        std::list<std::pair<T,T>> client_res (Server <T>& server)
-        {
-            std::list<std::pair<T,T>> results;
-            for (const auto& pair : task_id)
-            {
-                T result = server.request_result(pair.first);
-                results.push_back({pair.second, result});
-            }
-            return results;
-        }
-        void run (Server<T>& server, std::function<std::pair<T,T>()> gen_task)
-        {
-            auto task = gen_task();
-            int id = server.add_task([task]() {return task.second; });
-            task_id.push_back({id, task.first});
-        }
-
-};
+// Inputs come from a counter-based generator: value `index` of client
+// `client` is the same whichever thread produces it and in whatever order,
+// so the clients can submit from their own threads and the output files stay
+// reproducible.
+const uint64_t seed = 2024;
 
 template<typename T> 
-std::pair<T,T> fsinus()
+std::pair<T,T> fsinus(uint64_t client, uint64_t index)
 {
-    static std::default_random_engine gen;
-    static std::uniform_real_distribution<T> distr (-3.14159, 3.14159);
-    T x = distr(gen);
+    T x = philox::uniform(seed, client, index, -3.14159, 3.14159);
     return {x, std::sin(x)};
 }
 
 template<typename T> 
-std::pair<T,T> fsq()
+std::pair<T,T> fsq(uint64_t client, uint64_t index)
 {
-    static std::default_random_engine gen;
-    static std::uniform_real_distribution<T> distr (1.0, 10.0);
-    T x = distr(gen);
+    T x = philox::uniform(seed, client, index, 1.0, 10.0);
     return {x, std::sqrt(x)};
 }
 
 template<typename T> 
-std::pair<T,T> fpow()
+std::pair<T,T> fpow(uint64_t client, uint64_t index)
 {
-    static std::default_random_engine gen;
-    static std::uniform_real_distribution<T> distr (1.0, 10.0);
-    T x = distr(gen);
+    T x = philox::uniform(seed, client, index, 1.0, 10.0);
     return {x, std::pow(x, 2.0)};
 }
 
+// One client: `tasks` tasks from its own thread, results written every `window`.
+template<typename T, typename Gen, typename Write>
+void produce(Server<T>& server, uint64_t client, size_t tasks, size_t window, Gen gen, Write write)
+{
+    Client<T> cl;
+    cl.options.client = int(client);
+    for (size_t i = 0; i < tasks; i++)
+    {
+        cl.run(server, [=]() { return gen(client, i); });
+        if ((i + 1) % window == 0 || i + 1 == tasks)
+            cl.stream_res(server, write);
+    }
+}
+
 
 int main()
 {
+    // each client keeps at most `window` tasks pending
+    const size_t window = 1000;
     Server<double> server;
+    server.set_limit(3 * window);
     server.start();
-    Client<double> cl1;
-    Client<double> cl2;
-    Client<double> cl3;
-
-    for (size_t i = 0; i < 10000; i++)
-    {
-        cl1.run(server, fsinus<double>);
-        cl2.run(server, fsq<double>);
-        cl3.run(server, fpow<double>);
-    }
-    
-    std::list<std::pair<double, double>> thread1 = cl1.client_res(server);
-    std::list<std::pair<double, double>> thread2 = cl2.client_res(server);
-    std::list<std::pair<double, double>> thread3 = cl3.client_res(server);
-
-    server.stop();
 
     std::ofstream test1("test1.txt");
     std::ofstream test2("test2.txt");
     std::ofstream test3("test3.txt");
 
-    for (const auto& p:thread1)
-        test1 << "sinus ( " << p.first << " ) = " << p.second << std::endl;
-    test1.close();
+    std::thread t1([&]() {
+        produce(server, 1, 10000, window, fsinus<double>, [&](double x, double r) { test1 << "sinus ( " << x << " ) = " << r << std::endl; });
+    });
+    std::thread t2([&]() {
+        produce(server, 2, 10000, window, fsq<double>, [&](double x, double r) { test2 << "sqrt ( " << x << " ) = " << r << std::endl; });
+    });
+    std::thread t3([&]() {
+        produce(server, 3, 10000, window, fpow<double>, [&](double x, double r) { test3 << "pow ( " << x << " ) = " << r << std::endl; });
+    });
+    t1.join();
+    t2.join();
+    t3.join();
 
-    for (const auto& p:thread2)
-        test2 << "sqrt ( " << p.first << " ) = " << p.second << std::endl;
-    test2.close();
+    server.stop();
 
-    for (const auto& p:thread3)
-        test3 << "pow ( " << p.first << " ) = " << p.second << std::endl;
+    test1.close();
+    test2.close();
     test3.close();
 
 return 0;
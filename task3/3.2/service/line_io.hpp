@@ -0,0 +1,52 @@
+#pragma once
+#include <string>
+#include <cerrno>
+#include <unistd.h>
+
+// Line framing over a stream socket, shared by the solver service and its client.
+
+class LineReader {
+private:
+    int fd;
+    std::string buf;
+    size_t pos = 0;
+public:
+    explicit LineReader(int fd) : fd(fd) {}
+
+    // Next line without the '\n'; false at end of stream or on error.
+    bool next(std::string& line) {
+        while (true)
+        {
+            size_t nl = buf.find('\n', pos);
+            if (nl != std::string::npos)
+            {
+                line.assign(buf, pos, nl - pos);
+                pos = nl + 1;
+                return true;
+            }
+            buf.erase(0, pos);
+            pos = 0;
+            char chunk[4096];
+            ssize_t n = read(fd, chunk, sizeof(chunk));
+            if (n < 0 && errno == EINTR)
+                continue;
+            if (n <= 0)
+                return false;
+            buf.append(chunk, n);
+        }
+    }
+};
+
+inline bool writeAll(int fd, const std::string& s) {
+    size_t done = 0;
+    while (done < s.size())
+    {
+        ssize_t n = write(fd, s.data() + done, s.size() - done);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return false;
+        done += n;
+    }
+    return true;
+}
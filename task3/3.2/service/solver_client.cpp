@@ -0,0 +1,197 @@
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <chrono>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <boost/program_options.hpp>
+#include "line_io.hpp"
+namespace opt = boost::program_options;
+
+// Load generator for solver_service. Each connection keeps up to `inflight`
+// jobs outstanding and records the latency of every job from send to result;
+// at the end the client reports throughput and latency percentiles next to the
+// server's own queue/solve times. With --spawn the same jobs run as one
+// `<binary> --once` process each instead, the cold-start baseline.
+
+using Clock = std::chrono::steady_clock;
+
+struct Sample {
+    double latencyUs;
+    double queueUs;
+    double solveUs;
+};
+
+int connectTo(const std::string& path) {
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    std::strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+    if (fd < 0 || connect(fd, (sockaddr*)&addr, sizeof(addr)) < 0)
+    {
+        if (fd >= 0)
+            close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// parses "result <id> ok <iter> <error> <residual> <queue us> <solve us>"
+bool parseResult(const std::string& line, Sample& s, std::string& err) {
+    std::istringstream in(line);
+    std::string tag, id, status;
+    int iter;
+    double error, residual;
+    in >> tag >> id >> status;
+    if (tag != "result" || status != "ok")
+    {
+        err = line;
+        return false;
+    }
+    in >> iter >> error >> residual >> s.queueUs >> s.solveUs;
+    return bool(in);
+}
+
+// One connection: sends `jobs` jobs, never more than `inflight` unanswered.
+bool runConnection(const std::string& path, const std::string& job, int jobs, int inflight, std::vector<Sample>& out) {
+    int fd = connectTo(path);
+    if (fd < 0)
+    {
+        std::cerr << "Unable to connect to " << path << ": " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    std::vector<Clock::time_point> sent(jobs);
+    LineReader reader(fd);
+    std::string line, err;
+    int next = 0;
+    for (int done = 0; done < jobs; done++)
+    {
+        for (; next < jobs && next - done < inflight; next++)
+        {
+            sent[next] = Clock::now();
+            if (!writeAll(fd, "solve " + std::to_string(next) + " " + job + "\n"))
+                return false;
+        }
+        Sample s;
+        if (!reader.next(line) || !parseResult(line, s, err))
+        {
+            std::cerr << "Bad reply: " << err << std::endl;
+            close(fd);
+            return false;
+        }
+        s.latencyUs = std::chrono::duration<double, std::micro>(Clock::now() - sent[done]).count();
+        out.push_back(s);
+    }
+    close(fd);
+    return true;
+}
+
+// The baseline: a fresh process per job, run one after another.
+bool runSpawned(const std::string& binary, const std::string& job, int jobs, std::vector<Sample>& out) {
+    std::string cmd = binary + " --once '" + job + "'";
+    for (int j = 0; j < jobs; j++)
+    {
+        auto start = Clock::now();
+        FILE* p = popen(cmd.c_str(), "r");
+        if (!p)
+            return false;
+        char buf[512];
+        std::string line;
+        while (fgets(buf, sizeof(buf), p))
+            line += buf;
+        pclose(p);
+        Sample s;
+        std::string err;
+        if (!parseResult(line, s, err))
+        {
+            std::cerr << "Bad reply: " << err << std::endl;
+            return false;
+        }
+        s.latencyUs = std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+        out.push_back(s);
+    }
+    return true;
+}
+
+double percentile(std::vector<double> v, double p) {
+    std::sort(v.begin(), v.end());
+    size_t k = std::min(v.size() - 1, size_t(p * (v.size() - 1) + 0.5));
+    return v[k];
+}
+
+int main(int argc, char const *argv[])
+{
+    opt::options_description desc("Argument");
+    desc.add_options()
+        ("socket",opt::value<std::string>()->default_value("/tmp/heat_solver.sock"),"Unix socket of solver_service")
+        ("connections",opt::value<int>()->default_value(1),"Concurrent connections")
+        ("jobs",opt::value<int>()->default_value(100),"Jobs per connection")
+        ("inflight",opt::value<int>()->default_value(1),"Unanswered jobs allowed per connection")
+        ("solver",opt::value<std::string>()->default_value("jacobi"),"jacobi, sor or multigrid")
+        ("size",opt::value<int>()->default_value(64),"Grid size N")
+        ("accuracy",opt::value<double>()->default_value(1e-4),"Accuracy")
+        ("maxIter",opt::value<int>()->default_value(100000),"Iteration limit")
+        ("spawn",opt::value<std::string>(),"Run each job as `<binary> --once` instead of over the socket")
+        ("help","help");
+    opt::variables_map vm;
+    opt::store(opt::parse_command_line(argc, argv, desc), vm);
+    opt::notify(vm);
+    if (vm.count("help")) {
+        std::cout << desc << "\n";
+        return 1;
+    }
+    std::string job = vm["solver"].as<std::string>() + " " + std::to_string(vm["size"].as<int>()) + " " +
+                      std::to_string(vm["accuracy"].as<double>()) + " " + std::to_string(vm["maxIter"].as<int>());
+    int connections = std::max(vm["connections"].as<int>(), 1);
+    int jobs = std::max(vm["jobs"].as<int>(), 1);
+    int inflight = std::max(vm["inflight"].as<int>(), 1);
+
+    std::vector<std::vector<Sample>> samples(connections);
+    std::vector<char> ok(connections, 1);
+    auto start = Clock::now();
+    if (vm.count("spawn"))
+    {
+        connections = 1;
+        ok[0] = runSpawned(vm["spawn"].as<std::string>(), job, jobs, samples[0]);
+    }
+    else
+    {
+        std::vector<std::thread> threads;
+        for (int c = 0; c < connections; c++)
+            threads.emplace_back([&, c]() {
+                ok[c] = runConnection(vm["socket"].as<std::string>(), job, jobs, inflight, samples[c]);
+            });
+        for (auto& t : threads)
+            t.join();
+    }
+    std::chrono::duration<double> elapsed = Clock::now() - start;
+    if (std::find(ok.begin(), ok.end(), 0) != ok.end())
+        return 1;
+
+    std::vector<double> latency;
+    double queue = 0.0, solve = 0.0;
+    for (const auto& list : samples)
+        for (const Sample& s : list)
+        {
+            latency.push_back(s.latencyUs / 1000.0);
+            queue += s.queueUs / 1000.0;
+            solve += s.solveUs / 1000.0;
+        }
+    size_t n = latency.size();
+    std::cout << std::fixed << std::setprecision(3);
+    std::cout << "jobs: " << n << " (" << job << "), connections " << connections << ", inflight " << inflight << std::endl;
+    std::cout << "throughput: " << n / elapsed.count() << " jobs/s" << std::endl;
+    std::cout << "latency ms: p50 " << percentile(latency, 0.5) << "  p95 " << percentile(latency, 0.95)
+              << "  p99 " << percentile(latency, 0.99) << "  max " << percentile(latency, 1.0) << std::endl;
+    std::cout << "server ms (mean): queue " << queue / n << "  solve " << solve / n << std::endl;
+    return 0;
+}
@@ -0,0 +1,377 @@
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <deque>
+#include <map>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <memory>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstring>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <boost/program_options.hpp>
+#include "../server/server.hpp"
+#include "../../../task6/check_policy.hpp"
+#include "../../../task6/cpu/stencil.hpp"
+#include "../../../task6/cpu/solvers.hpp"
+#include "line_io.hpp"
+namespace opt = boost::program_options;
+
+// Long-lived solver process. Jobs arrive as text lines on a Unix domain
+// socket and run as Server<JobResult> tasks on a fixed set of worker threads;
+// grids come from the grid_alloc pool, so a repeated size reuses warm memory.
+//
+//   client: solve <id> <jacobi|sor|multigrid> <N> <accuracy> [maxIter]
+//   server: result <id> ok <iterations> <error> <residual> <queue us> <solve us>
+//           result <id> error <message>
+//   client: stats
+//   server: stats jobs <n> workers <w> pool_hits <h> pool_misses <m>
+//
+// Results of one connection come back in the order the jobs were sent.
+
+using Clock = std::chrono::steady_clock;
+
+struct Job {
+    std::string solver;
+    int N = 0;
+    double accuracy = 1e-6;
+    int maxIter = 1000000;
+};
+
+struct JobResult {
+    bool ok = false;
+    std::string message;
+    int iter = 0;
+    double error = 0.0;
+    double residual = 0.0;
+    double queueUs = 0.0;
+    double solveUs = 0.0;
+};
+
+// maxCells bounds N^2: a job holds two N x N double grids (multigrid about
+// one more), so one line must not be able to exhaust the service's memory.
+bool parseJob(std::istringstream& in, Job& job, size_t maxCells, std::string& err) {
+    in >> job.solver >> job.N >> job.accuracy;
+    if (!in)
+    {
+        err = "expected: solve <id> <solver> <N> <accuracy> [maxIter]";
+        return false;
+    }
+    std::string extra;
+    if (in >> extra)
+    {
+        size_t used = 0;
+        try
+        {
+            job.maxIter = std::stoi(extra, &used);
+        }
+        catch (const std::exception&)
+        {
+            used = 0;
+        }
+        if (used != extra.size() || job.maxIter <= 0)
+        {
+            err = "maxIter must be a positive integer";
+            return false;
+        }
+    }
+    if (job.solver != "jacobi" && job.solver != "sor" && job.solver != "multigrid")
+    {
+        err = "unknown solver " + job.solver;
+        return false;
+    }
+    if (job.N < 3)
+    {
+        err = "N out of range";
+        return false;
+    }
+    if (size_t(job.N) * job.N > maxCells)
+    {
+        err = "N^2 exceeds maxCells " + std::to_string(maxCells);
+        return false;
+    }
+    return true;
+}
+
+// The task6 problem (corner-interpolated edges, no source) on one worker thread.
+JobResult solveJob(const Job& job, Clock::time_point submitted) {
+    auto start = Clock::now();
+    JobResult r;
+    r.queueUs = std::chrono::duration<double, std::micro>(start - submitted).count();
+    int N = job.N;
+    stencil::Extents<> ext(N, N);
+    auto a = grid_alloc::make_array<double>(size_t(N) * N);
+    auto b = grid_alloc::make_array<double>(size_t(N) * N);
+    stencil::CornerInterpolated::init<2>(a.get(), ext, 1);
+    stencil::CornerInterpolated::init<2>(b.get(), ext, 1);
+    double* prev = a.get();
+    double* cur = b.get();
+    std::unique_ptr<Multigrid<double>> mg;
+    if (job.solver == "multigrid")
+        mg.reset(new Multigrid<double>(N));
+    double omega = optimalOmega(N);
+    CheckPolicy check(job.solver == "jacobi" ? 100 : job.solver == "sor" ? 10 : 1, false, job.accuracy);
+    double error = 1.0;
+    int iter = 0;
+    while (iter < job.maxIter && error > job.accuracy)
+    {
+        bool checkNow = check.due(iter+1);
+        double delta;
+        if (mg)
+            delta = mg->cycle(prev, nullptr, checkNow);
+        else if (job.solver == "sor")
+            delta = sorSweep<double>(prev, nullptr, N, omega, checkNow);
+        else
+        {
+            delta = stencil::sweep<stencil::Point5, double>(cur, prev, ext, checkNow);
+            std::swap(prev, cur);
+        }
+        if (checkNow)
+        {
+            error = delta;
+            check.update(iter+1, error);
+        }
+        iter++;
+    }
+    r.ok = true;
+    r.iter = iter;
+    r.error = error;
+    r.residual = jacobiResidual<double>(prev, nullptr, N);
+    r.solveUs = std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+    return r;
+}
+
+std::string formatResult(const std::string& id, const JobResult& r) {
+    std::ostringstream out;
+    out.precision(6);
+    if (r.ok)
+        out << "result " << id << " ok " << r.iter << ' ' << r.error << ' ' << r.residual << ' '
+            << r.queueUs << ' ' << r.solveUs << '\n';
+    else
+        out << "result " << id << " error " << r.message << '\n';
+    return out.str();
+}
+
+class Service {
+private:
+    Server<JobResult> server;
+    int workers;
+    size_t maxCells;
+    std::atomic<long> jobs{0};
+    int listenFd = -1;
+    // Open connections by id. A finishing connection moves its thread to
+    // `finished` and closes its fd under connMut, so `connections` only holds
+    // fds that are still open; listen joins `finished` on every accept.
+    struct Connection {
+        int fd;
+        std::thread thread;
+    };
+    std::mutex connMut;
+    std::condition_variable connCv;
+    std::map<uint64_t, Connection> connections;
+    std::vector<std::thread> finished;
+    uint64_t nextConn = 0;
+
+    void joinFinished() {
+        std::vector<std::thread> done;
+        {
+            std::unique_lock<std::mutex> lock(connMut);
+            done.swap(finished);
+        }
+        for (auto& t : done)
+            t.join();
+    }
+
+    // Reader side of a connection: parses lines and submits; the writer thread
+    // collects the results in order, so the reader never waits on a solve.
+    void connection(uint64_t id, int fd) {
+        struct Pending {
+            std::string id;
+            size_t task;        // 0: rejected, `error` holds the reply
+            std::string error;
+        };
+        std::deque<Pending> pending;
+        std::mutex mut;
+        std::condition_variable cv;
+        bool done = false;
+
+        std::thread writer([&]() {
+            bool broken = false;
+            while (true)
+            {
+                Pending p;
+                {
+                    std::unique_lock<std::mutex> lock(mut);
+                    cv.wait(lock, [&]() { return !pending.empty() || done; });
+                    if (pending.empty())
+                        break;
+                    p = std::move(pending.front());
+                    pending.pop_front();
+                }
+                // once the client is gone the results are still collected, so
+                // their slots go back to the server, and then dropped
+                std::string line = p.task ? formatResult(p.id, server.request_result(p.task)) : p.error;
+                if (!broken && !writeAll(fd, line))
+                    broken = true;
+            }
+        });
+
+        LineReader reader(fd);
+        std::string line;
+        while (reader.next(line))
+        {
+            std::istringstream in(line);
+            std::string cmd;
+            in >> cmd;
+            Pending p;
+            if (cmd == "solve")
+            {
+                in >> p.id;
+                Job job;
+                std::string err;
+                if (parseJob(in, job, maxCells, err))
+                {
+                    auto submitted = Clock::now();
+                    p.task = server.add_task([job, submitted]() { return solveJob(job, submitted); });
+                    jobs++;
+                }
+                else
+                {
+                    p.task = 0;
+                    p.error = "result " + p.id + " error " + err + "\n";
+                }
+            }
+            else if (cmd == "stats")
+            {
+                auto& pool = grid_alloc::Pool::instance();
+                p.task = 0;
+                p.error = "stats jobs " + std::to_string(jobs.load()) + " workers " + std::to_string(workers) +
+                          " pool_hits " + std::to_string(pool.hits.load()) + " pool_misses " + std::to_string(pool.misses.load()) + "\n";
+            }
+            else if (cmd.empty())
+                continue;
+            else
+            {
+                p.task = 0;
+                p.error = "error unknown command " + cmd + "\n";
+            }
+            {
+                std::unique_lock<std::mutex> lock(mut);
+                pending.push_back(std::move(p));
+            }
+            cv.notify_one();
+        }
+        {
+            std::unique_lock<std::mutex> lock(mut);
+            done = true;
+        }
+        cv.notify_one();
+        writer.join();
+        std::unique_lock<std::mutex> lock(connMut);
+        auto it = connections.find(id);
+        finished.push_back(std::move(it->second.thread));
+        connections.erase(it);
+        close(fd);
+        connCv.notify_all();
+    }
+
+public:
+    Service(int workers, size_t maxCells) : server(workers), workers(workers), maxCells(maxCells) {}
+
+    int listen(const std::string& path) {
+        listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+        sockaddr_un addr;
+        std::memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        std::strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+        unlink(path.c_str());
+        if (listenFd < 0 || bind(listenFd, (sockaddr*)&addr, sizeof(addr)) < 0 || ::listen(listenFd, 64) < 0)
+        {
+            std::cerr << "Unable to listen on " << path << ": " << std::strerror(errno) << std::endl;
+            return 1;
+        }
+        server.start();
+        std::cout << "listening on " << path << " with " << workers << " workers" << std::endl;
+        while (true)
+        {
+            int fd = accept(listenFd, nullptr, nullptr);
+            if (fd < 0)
+            {
+                if (errno == EINTR)
+                    continue;
+                break;      // shutdown() from the signal handler
+            }
+            joinFinished();
+            // the thread is started under the lock, so it cannot look itself
+            // up in `connections` before it is there
+            std::unique_lock<std::mutex> lock(connMut);
+            uint64_t id = nextConn++;
+            connections[id].fd = fd;
+            connections[id].thread = std::thread(&Service::connection, this, id, fd);
+        }
+        {
+            std::unique_lock<std::mutex> lock(connMut);
+            for (auto& c : connections)
+                shutdown(c.second.fd, SHUT_RD);
+            connCv.wait(lock, [this]() { return connections.empty(); });
+        }
+        joinFinished();
+        server.stop();
+        unlink(path.c_str());
+        return 0;
+    }
+
+    void interrupt() {
+        shutdown(listenFd, SHUT_RDWR);
+    }
+};
+
+Service* service = nullptr;
+
+void onSignal(int) {
+    if (service)
+        service->interrupt();
+}
+
+int main(int argc, char const *argv[])
+{
+    opt::options_description desc("Argument");
+    desc.add_options()
+        ("socket",opt::value<std::string>()->default_value("/tmp/heat_solver.sock"),"Unix socket path")
+        ("workers",opt::value<int>()->default_value(std::thread::hardware_concurrency()),"Solver threads")
+        ("maxCells",opt::value<size_t>()->default_value(size_t(4096) * 4096),"Largest N^2 a job may ask for (about 16 bytes each, more for multigrid)")
+        ("once",opt::value<std::string>(),"Solve one job \"<solver> <N> <accuracy> [maxIter]\" and exit, like a fresh process per job")
+        ("help","help");
+    opt::variables_map vm;
+    opt::store(opt::parse_command_line(argc, argv, desc), vm);
+    opt::notify(vm);
+    if (vm.count("help")) {
+        std::cout << desc << "\n";
+        return 1;
+    }
+    if (vm.count("once"))
+    {
+        std::istringstream in(vm["once"].as<std::string>());
+        Job job;
+        std::string err;
+        if (!parseJob(in, job, vm["maxCells"].as<size_t>(), err))
+        {
+            std::cerr << err << std::endl;
+            return 1;
+        }
+        std::cout << formatResult("0", solveJob(job, Clock::now()));
+        return 0;
+    }
+    Service s(std::max(vm["workers"].as<int>(), 1), vm["maxCells"].as<size_t>());
+    service = &s;
+    std::signal(SIGINT, onSignal);
+    std::signal(SIGTERM, onSignal);
+    std::signal(SIGPIPE, SIG_IGN);
+    return s.listen(vm["socket"].as<std::string>());
+}
@@ -0,0 +1,393 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Native version of the task4 acquisition loop. Each sensor gets its own
+// producer thread, which pushes every reading into a lock-free
+// single-producer/single-consumer ring. When the ring is full the reading is
+// counted as dropped, so a producer never waits for anyone.
+//
+// The aggregator thread wakes every `tick`, drains all rings and keeps the
+// newest sample of each sensor. It publishes them as one snapshot under a
+// sequence lock. latest() copies that snapshot from any thread without taking
+// a lock. A slow or stalled sensor only makes its own entry older and never
+// delays the others. A consumer that reads latest() every P therefore sees
+// data at most tick + P after the aggregator got it.
+//
+// The aggregator measures, per sensor, the time from a reading to the
+// snapshot that carries it. It also measures how late each tick wakes up
+// (jitter). stats() returns both once the pipeline is stopped.
+namespace pipeline {
+
+using Clock = std::chrono::steady_clock;
+
+inline int64_t nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count();
+}
+
+struct Sample {
+    uint64_t seq = 0;       // 1, 2, ... per sensor; 0 = nothing yet
+    int64_t value = 0;
+    int64_t stamp = 0;      // nowNs() when the reading was taken
+};
+
+// Lets stop() interrupt producers and the aggregator while they sleep.
+class Stop {
+private:
+    std::mutex mut;
+    std::condition_variable cv;
+    bool stopped = false;
+public:
+    // Sleeps until `t`; false if the pipeline was stopped meanwhile.
+    bool sleepUntil(Clock::time_point t) {
+        std::unique_lock<std::mutex> lock(mut);
+        return !cv.wait_until(lock, t, [this] { return stopped; });
+    }
+    void request() {
+        {
+            std::lock_guard<std::mutex> lock(mut);
+            stopped = true;
+        }
+        cv.notify_all();
+    }
+    void reset() {
+        std::lock_guard<std::mutex> lock(mut);
+        stopped = false;
+    }
+};
+
+class Sensor {
+public:
+    virtual ~Sensor() = default;
+    // Blocks until the next reading; false when stopped.
+    virtual bool read(int64_t& value, Stop& stop) = 0;
+};
+
+// SensorX of task4.py: a counter that takes `period` per reading. The
+// deadlines are absolute, so the rate does not drift with the loop
+// overhead. A period of 0 returns at once (a free-running sensor).
+class MockSensor : public Sensor {
+private:
+    std::chrono::nanoseconds period;
+    Clock::time_point next{};      // set by the first read
+    int64_t data = 0;
+public:
+    explicit MockSensor(double periodSeconds)
+        : period(std::chrono::nanoseconds(int64_t(periodSeconds * 1e9))) {}
+
+    bool read(int64_t& value, Stop& stop) override {
+        if (period.count() > 0)
+        {
+            if (next == Clock::time_point())
+                next = Clock::now();
+            next += period;
+            if (!stop.sleepUntil(next))
+                return false;
+        }
+        value = ++data;
+        return true;
+    }
+};
+
+// Lock-free single-producer/single-consumer ring. The capacity is rounded
+// up to a power of two. Each side keeps a cached copy of the other side's
+// index, so it touches the shared line only when the ring looks full or
+// empty.
+template <class T>
+class SpscRing {
+private:
+    std::unique_ptr<T[]> slots;
+    size_t mask;
+    alignas(64) std::atomic<size_t> head{0};    // next write, owned by the producer
+    size_t cachedTail = 0;
+    alignas(64) std::atomic<size_t> tail{0};    // next read, owned by the consumer
+    size_t cachedHead = 0;
+public:
+    explicit SpscRing(size_t capacity) {
+        size_t c = 1;
+        while (c < std::max<size_t>(capacity, 1))
+            c *= 2;
+        slots.reset(new T[c]);
+        mask = c - 1;
+    }
+
+    size_t capacity() const {
+        return mask + 1;
+    }
+
+    bool push(const T& v) {
+        size_t h = head.load(std::memory_order_relaxed);
+        if (h - cachedTail > mask)
+        {
+            cachedTail = tail.load(std::memory_order_acquire);
+            if (h - cachedTail > mask)
+                return false;
+        }
+        slots[h & mask] = v;
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool pop(T& v) {
+        size_t t = tail.load(std::memory_order_relaxed);
+        if (t == cachedHead)
+        {
+            cachedHead = head.load(std::memory_order_acquire);
+            if (t == cachedHead)
+                return false;
+        }
+        v = slots[t & mask];
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+};
+
+// Log-linear latency histogram: 32 buckets per power of two, so the
+// percentiles are within about 3 %. Values are in nanoseconds.
+class Histogram {
+private:
+    static constexpr int Sub = 32;
+    std::vector<uint64_t> counts = std::vector<uint64_t>(64 * Sub, 0);
+    uint64_t total = 0;
+    int64_t maxValue = 0;
+    double sum = 0.0;
+
+    static int index(int64_t v) {
+        if (v < Sub)
+            return int(std::max<int64_t>(v, 0));
+        int e = 63 - __builtin_clzll(uint64_t(v));       // v in [2^e, 2^(e+1))
+        return (e - 4) * Sub + int((v >> (e - 5)) & (Sub - 1));
+    }
+    static int64_t lower(int i) {
+        if (i < Sub)
+            return i;
+        int e = i / Sub + 4;
+        return (int64_t(1) << e) + (int64_t(i % Sub) << (e - 5));
+    }
+public:
+    void record(int64_t v) {
+        counts[index(v)]++;
+        total++;
+        maxValue = std::max(maxValue, v);
+        sum += double(v);
+    }
+    uint64_t count() const {
+        return total;
+    }
+    double mean() const {
+        return total ? sum / total : 0.0;
+    }
+    int64_t max() const {
+        return maxValue;
+    }
+    // Lower edge of the bucket holding the p-quantile, p in [0, 1].
+    int64_t percentile(double p) const {
+        uint64_t rank = uint64_t(p * (total ? total - 1 : 0)), seen = 0;
+        for (size_t i = 0; i < counts.size(); i++)
+        {
+            seen += counts[i];
+            if (seen > rank)
+                return std::min(lower(int(i)), maxValue);
+        }
+        return maxValue;
+    }
+};
+
+struct SensorStats {
+    uint64_t produced = 0;  // readings taken
+    uint64_t dropped = 0;   // readings that found the ring full
+    Histogram latency;      // reading -> published snapshot, every delivered reading
+};
+
+struct Stats {
+    std::vector<SensorStats> sensors;
+    Histogram jitter;       // how late the aggregator's ticks woke up
+    uint64_t ticks = 0;
+};
+
+struct Snapshot {
+    uint64_t tick = 0;      // aggregator tick that published it
+    int64_t published = 0;  // nowNs() at publication
+    std::vector<Sample> samples;
+};
+
+class Pipeline {
+private:
+    struct Channel {
+        std::unique_ptr<Sensor> sensor;
+        SpscRing<Sample> ring;
+        std::atomic<uint64_t> produced{0};
+        std::atomic<uint64_t> dropped{0};
+        Channel(std::unique_ptr<Sensor> s, size_t capacity) : sensor(std::move(s)), ring(capacity) {}
+    };
+
+    std::vector<std::unique_ptr<Channel>> channels;
+    std::chrono::nanoseconds tick;
+    Stop stop;
+    std::atomic<bool> running{false};     // free-running sensors never sleep on `stop`
+    std::vector<std::thread> threads;
+    Stats counters;
+
+    // The published snapshot: odd `version` while the aggregator writes it.
+    // The fields are relaxed atomics so readers racing with it are well defined.
+    std::atomic<uint64_t> version{0};
+    std::atomic<uint64_t> pubTick{0};
+    std::atomic<int64_t> pubTime{0};
+    std::unique_ptr<std::atomic<uint64_t>[]> pubSeq;
+    std::unique_ptr<std::atomic<int64_t>[]> pubValue;
+    std::unique_ptr<std::atomic<int64_t>[]> pubStamp;
+
+    void produce(Channel& c) {
+        uint64_t seq = 0;
+        int64_t value;
+        while (running.load(std::memory_order_relaxed) && c.sensor->read(value, stop))
+        {
+            Sample s{++seq, value, nowNs()};
+            c.produced.fetch_add(1, std::memory_order_relaxed);
+            if (!c.ring.push(s))
+                c.dropped.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    void aggregate() {
+        size_t n = channels.size();
+        std::vector<Sample> latest(n);
+        std::vector<std::pair<size_t, int64_t>> drained;    // (sensor, stamp) of this tick's readings
+        Clock::time_point next = Clock::now();
+        for (uint64_t t = 1;; t++)
+        {
+            next += tick;
+            if (!stop.sleepUntil(next))
+                break;
+            counters.jitter.record(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - next).count());
+            drained.clear();
+            for (size_t k = 0; k < n; k++)
+            {
+                Sample s;
+                while (channels[k]->ring.pop(s))
+                {
+                    latest[k] = s;
+                    drained.emplace_back(k, s.stamp);
+                }
+            }
+            uint64_t v = version.load(std::memory_order_relaxed);
+            version.store(v + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            for (size_t k = 0; k < n; k++)
+            {
+                pubSeq[k].store(latest[k].seq, std::memory_order_relaxed);
+                pubValue[k].store(latest[k].value, std::memory_order_relaxed);
+                pubStamp[k].store(latest[k].stamp, std::memory_order_relaxed);
+            }
+            pubTick.store(t, std::memory_order_relaxed);
+            int64_t published = nowNs();
+            pubTime.store(published, std::memory_order_relaxed);
+            version.store(v + 2, std::memory_order_release);
+            counters.ticks = t;
+            // a reading superseded within the same tick still counts: it
+            // reached the snapshot, only to be overwritten there
+            for (const auto& d : drained)
+                counters.sensors[d.first].latency.record(published - d.second);
+        }
+    }
+
+public:
+    Pipeline(std::vector<std::unique_ptr<Sensor>> sensors, double tickSeconds, size_t ringCapacity = 64)
+        : tick(std::chrono::nanoseconds(std::max<int64_t>(1, int64_t(tickSeconds * 1e9)))) {
+        for (auto& s : sensors)
+            channels.emplace_back(new Channel(std::move(s), ringCapacity));
+        size_t n = channels.size();
+        pubSeq.reset(new std::atomic<uint64_t>[n]);
+        pubValue.reset(new std::atomic<int64_t>[n]);
+        pubStamp.reset(new std::atomic<int64_t>[n]);
+        for (size_t k = 0; k < n; k++)
+        {
+            pubSeq[k].store(0);
+            pubValue[k].store(0);
+            pubStamp[k].store(0);
+        }
+    }
+
+    ~Pipeline() {
+        stopAll();
+    }
+
+    size_t size() const {
+        return channels.size();
+    }
+
+    void start() {
+        if (!threads.empty())
+            return;
+        stop.reset();
+        running = true;
+        counters = Stats();
+        counters.sensors.resize(channels.size());
+        for (auto& c : channels)
+        {
+            c->produced = 0;
+            c->dropped = 0;
+        }
+        for (auto& c : channels)
+            threads.emplace_back([this, ch = c.get()] { produce(*ch); });
+        threads.emplace_back([this] { aggregate(); });
+    }
+
+    // Stops and joins every thread; a sensor stuck inside a real read()
+    // delays this until the read returns.
+    void stopAll() {
+        if (threads.empty())
+            return;
+        running = false;
+        stop.request();
+        for (auto& t : threads)
+            t.join();
+        threads.clear();
+        for (size_t k = 0; k < channels.size(); k++)
+        {
+            counters.sensors[k].produced = channels[k]->produced.load();
+            counters.sensors[k].dropped = channels[k]->dropped.load();
+        }
+    }
+
+    // The newest published snapshot; never blocks, retries while the
+    // aggregator is in the middle of publishing.
+    Snapshot latest() const {
+        Snapshot s;
+        s.samples.resize(channels.size());
+        for (;;)
+        {
+            uint64_t v = version.load(std::memory_order_acquire);
+            if (v % 2 == 0)
+            {
+                for (size_t k = 0; k < s.samples.size(); k++)
+                {
+                    s.samples[k].seq = pubSeq[k].load(std::memory_order_relaxed);
+                    s.samples[k].value = pubValue[k].load(std::memory_order_relaxed);
+                    s.samples[k].stamp = pubStamp[k].load(std::memory_order_relaxed);
+                }
+                s.tick = pubTick.load(std::memory_order_relaxed);
+                s.published = pubTime.load(std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (version.load(std::memory_order_relaxed) == v)
+                    return s;
+            }
+            std::this_thread::yield();
+        }
+    }
+
+    // Counters and histograms of the last run; complete after stopAll().
+    const Stats& stats() const {
+        return counters;
+    }
+};
+
+}
@@ -0,0 +1,79 @@
+'''ctypes binding of the native sensor pipeline (pipeline.hpp, libpipeline.so).
+
+    with Pipeline([1, 0.1, 0.01], tick=0.001) as p:
+        values, ages, tick = p.latest()
+
+Every sensor is a mock SensorX with the given period in seconds. latest()
+never blocks: it returns the newest value of every sensor, how old each one
+is in seconds (-1 before the first reading) and the aggregator tick that
+published them.
+'''
+import ctypes
+import os
+
+_lib = None
+
+
+def _load(path=None):
+    global _lib
+    if _lib is None:
+        path = path or os.path.join(os.path.dirname(os.path.abspath(__file__)), 'libpipeline.so')
+        lib = ctypes.CDLL(path)
+        lib.pipeline_create.restype = ctypes.c_void_p
+        lib.pipeline_create.argtypes = [ctypes.c_int, ctypes.POINTER(ctypes.c_double), ctypes.c_double, ctypes.c_int]
+        lib.pipeline_destroy.argtypes = [ctypes.c_void_p]
+        lib.pipeline_start.argtypes = [ctypes.c_void_p]
+        lib.pipeline_stop.argtypes = [ctypes.c_void_p]
+        lib.pipeline_latest.restype = ctypes.c_ulonglong
+        lib.pipeline_latest.argtypes = [ctypes.c_void_p, ctypes.POINTER(ctypes.c_longlong),
+                                        ctypes.POINTER(ctypes.c_double), ctypes.c_int]
+        lib.pipeline_stats.restype = ctypes.c_int
+        lib.pipeline_stats.argtypes = [ctypes.c_void_p, ctypes.POINTER(ctypes.c_double), ctypes.c_int]
+        _lib = lib
+    return _lib
+
+
+class Pipeline:
+
+    def __init__(self, periods, tick=0.001, ring=64, library=None):
+        self._lib = _load(library)
+        self._n = len(periods)
+        arr = (ctypes.c_double * self._n)(*periods)
+        self._handle = self._lib.pipeline_create(self._n, arr, tick, ring)
+        self._values = (ctypes.c_longlong * self._n)()
+        self._ages = (ctypes.c_double * self._n)()
+
+    def start(self):
+        self._lib.pipeline_start(self._handle)
+
+    def stop(self):
+        self._lib.pipeline_stop(self._handle)
+
+    def latest(self):
+        tick = self._lib.pipeline_latest(self._handle, self._values, self._ages, self._n)
+        return list(self._values), list(self._ages), tick
+
+    def stats(self):
+        '''Counters of the last run (after stop()): one dict per sensor and the aggregator's.'''
+        size = 6 * self._n + 4
+        out = (ctypes.c_double * size)()
+        self._lib.pipeline_stats(self._handle, out, size)
+        keys = ('produced', 'dropped', 'delivered', 'latency_p50', 'latency_p99', 'latency_max')
+        sensors = [dict(zip(keys, out[6 * k:6 * k + 6])) for k in range(self._n)]
+        ticks = dict(zip(('ticks', 'jitter_p50', 'jitter_p99', 'jitter_max'), out[6 * self._n:size]))
+        return sensors, ticks
+
+    def close(self):
+        if self._handle:
+            self._lib.pipeline_destroy(self._handle)
+            self._handle = None
+
+    def __enter__(self):
+        self.start()
+        return self
+
+    def __exit__(self, *exc):
+        self.stop()
+
+    def __del__(self):
+        self.close()
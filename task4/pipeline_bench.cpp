@@ -0,0 +1,84 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "pipeline.hpp"
+
+// Latency and jitter of the native pipeline. Mock sensors run with periods
+// of 10 ms, 1 ms, 100 us and 10 us, plus one free-running sensor (period 0)
+// that floods its ring. A consumer thread reads latest() every `consumer`
+// us, like the display loop of task4.py.
+// Per sensor it prints the readings taken, dropped and delivered, and the
+// latency from reading to published snapshot. It also prints how late the
+// aggregator's ticks woke up, and the age of new values when the consumer
+// saw them.
+// usage: pipeline_bench [seconds] [tick, us] [consumer period, us] [sensor periods, us ...]
+
+void row(const std::string& name, const pipeline::Histogram& h) {
+    std::cout << std::setw(12) << std::fixed << std::setprecision(1) << h.percentile(0.5) * 1e-3 << std::setw(12)
+              << h.percentile(0.99) * 1e-3 << std::setw(12) << h.max() * 1e-3 << "  " << name << std::endl;
+}
+
+int main(int argc, char const *argv[])
+{
+    double seconds = argc > 1 ? std::atof(argv[1]) : 5.0;
+    double tick = (argc > 2 ? std::atof(argv[2]) : 100.0) * 1e-6;
+    double consumer = (argc > 3 ? std::atof(argv[3]) : 1000.0) * 1e-6;
+    std::vector<double> periods = {1e-2, 1e-3, 1e-4, 1e-5, 0.0};
+    if (argc > 4)
+        periods.clear();
+    for (int a = 4; a < argc; a++)
+        periods.push_back(std::atof(argv[a]) * 1e-6);
+    std::vector<std::unique_ptr<pipeline::Sensor>> sensors;
+    for (double p : periods)
+        sensors.emplace_back(new pipeline::MockSensor(p));
+    pipeline::Pipeline pipe(std::move(sensors), tick, 64);
+
+    std::vector<pipeline::Histogram> age(periods.size());
+    std::vector<uint64_t> seen(periods.size(), 0);
+    uint64_t reads = 0;
+    pipe.start();
+    auto start = pipeline::Clock::now();
+    auto next = start;
+    auto end = start + std::chrono::nanoseconds(int64_t(seconds * 1e9));
+    while (next < end)
+    {
+        next += std::chrono::nanoseconds(int64_t(consumer * 1e9));
+        std::this_thread::sleep_until(next);
+        pipeline::Snapshot s = pipe.latest();
+        int64_t now = pipeline::nowNs();
+        reads++;
+        for (size_t k = 0; k < periods.size(); k++)
+            if (s.samples[k].seq != seen[k])
+            {
+                seen[k] = s.samples[k].seq;
+                age[k].record(now - s.samples[k].stamp);
+            }
+    }
+    pipe.stopAll();
+    const pipeline::Stats& st = pipe.stats();
+
+    std::cout << seconds << " s, tick " << tick * 1e6 << " us, consumer every " << consumer * 1e6 << " us, "
+              << st.ticks << " ticks, " << reads << " consumer reads" << std::endl;
+    std::cout << std::setw(10) << "period" << std::setw(12) << "readings/s" << std::setw(10) << "dropped"
+              << std::setw(12) << "delivered" << std::setw(12) << "p50, us" << std::setw(12) << "p99, us"
+              << std::setw(12) << "max, us" << std::endl;
+    for (size_t k = 0; k < periods.size(); k++)
+    {
+        const pipeline::SensorStats& s = st.sensors[k];
+        std::string period = periods[k] > 0 ? std::to_string(std::lround(periods[k] * 1e6)) + " us" : "free";
+        std::cout << std::setw(10) << period << std::setw(12) << std::fixed << std::setprecision(0)
+                  << s.produced / seconds << std::setw(10) << s.dropped << std::setw(12) << s.latency.count();
+        row("reading -> snapshot", s.latency);
+        std::cout << std::setw(44) << "";
+        row("age when the consumer saw it", age[k]);
+    }
+    std::cout << std::setw(44) << "aggregator tick lateness";
+    row("", st.jitter);
+    return 0;
+}
@@ -0,0 +1,114 @@
+'''Python side of the pipeline benchmark: the thread/Queue loop of task4.py
+against the native pipeline through its binding, with the same sensors and
+the same 1 ms consumer loop (the cv2.waitKey(1) of task4.py).
+
+For every new value the consumer sees it records the value's age. It also
+records how late each consumer iteration starts (jitter) and how many
+readings per second each sensor thread managed to take.
+
+usage: python3 pipeline_bench.py [seconds] [sensor periods, s ...]
+'''
+import sys
+import threading
+import time
+from queue import Queue
+
+from pipeline import Pipeline
+
+
+class StampedSensorX:
+    '''task4.SensorX that also returns when the reading was taken.'''
+
+    def __init__(self, delay):
+        self._delay = delay
+        self._data = 0
+
+    def get(self):
+        time.sleep(self._delay)
+        self._data += 1
+        return self._data, time.perf_counter()
+
+
+def push(sensor, queue, stop, produced, k):
+    '''task4.push with a stop flag and a count of readings.'''
+    while not stop.is_set():
+        if queue.full():
+            _ = queue.get_nowait()
+        else:
+            queue.put_nowait(sensor.get())
+            produced[k] += 1
+
+
+def percentiles(values):
+    if not values:
+        return '     -          -          -'
+    v = sorted(values)
+    pick = lambda p: v[min(len(v) - 1, int(p * (len(v) - 1)))] * 1e6
+    return f'{pick(0.5):10.1f} {pick(0.99):10.1f} {v[-1] * 1e6:10.1f}'
+
+
+def consume(seconds, read, n):
+    '''Calls read() every 1 ms; read returns (values, stamps) with None for no news.'''
+    ages = [[] for _ in range(n)]
+    late = []
+    start = time.perf_counter()
+    deadline = start
+    while deadline < start + seconds:
+        deadline += 0.001
+        time.sleep(max(0.0, deadline - time.perf_counter()))
+        now = time.perf_counter()
+        late.append(now - deadline)
+        for k, stamp in enumerate(read(now)):
+            if stamp is not None:
+                ages[k].append(now - stamp)
+    return ages, late
+
+
+def python_queues(seconds, periods):
+    stop = threading.Event()
+    queues = [Queue(2) for _ in periods]
+    produced = [0] * len(periods)
+    threads = [threading.Thread(target=push, args=(StampedSensorX(p), q, stop, produced, k), daemon=True)
+               for k, (p, q) in enumerate(zip(periods, queues))]
+    for t in threads:
+        t.start()
+
+    def read(now):
+        stamps = []
+        for q in queues:
+            stamp = None
+            if not q.empty():
+                _, stamp = q.get_nowait()
+            stamps.append(stamp)
+        return stamps
+
+    ages, late = consume(seconds, read, len(periods))
+    stop.set()
+    return ages, late, produced
+
+
+def native(seconds, periods):
+    seen = [0] * len(periods)
+    with Pipeline(periods, tick=0.0001) as p:
+        def read(now):
+            values, age, _ = p.latest()
+            stamps = []
+            for k, v in enumerate(values):
+                stamps.append(now - age[k] if v != seen[k] and age[k] >= 0 else None)
+                seen[k] = v
+            return stamps
+
+        ages, late = consume(seconds, read, len(periods))
+    return ages, late, [s['produced'] for s in p.stats()[0]]
+
+
+if __name__ == '__main__':
+    seconds = float(sys.argv[1]) if len(sys.argv) > 1 else 5.0
+    periods = [float(a) for a in sys.argv[2:]] or [0.01, 0.001, 0.0001]
+    print(f'{seconds} s, consumer every 1 ms; age of new values and consumer lateness, us')
+    print(f'{"":10} {"sensor":>10} {"readings/s":>11} {"values":>8} {"p50":>10} {"p99":>10} {"max":>10}')
+    for name, run in (('queues', python_queues), ('native', native)):
+        ages, late, produced = run(seconds, periods)
+        for p, a, n in zip(periods, ages, produced):
+            print(f'{name:10} {p * 1e6:8.0f}us {n / seconds:11.0f} {len(a):8} {percentiles(a)}')
+        print(f'{name:10} {"lateness":>10} {"":11} {len(late):8} {percentiles(late)}')
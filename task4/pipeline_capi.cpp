@@ -0,0 +1,62 @@
+#include <algorithm>
+#include <memory>
+#include <vector>
+#include "pipeline.hpp"
+
+// C interface of pipeline.hpp for the ctypes binding in pipeline.py,
+// built as libpipeline.so. Every sensor is a MockSensor with the given
+// period in seconds (task4.py's SensorX). Times come back in seconds.
+
+extern "C" {
+
+void* pipeline_create(int sensors, const double* periods, double tick, int ringCapacity) {
+    std::vector<std::unique_ptr<pipeline::Sensor>> list;
+    for (int k = 0; k < sensors; k++)
+        list.emplace_back(new pipeline::MockSensor(periods[k]));
+    return new pipeline::Pipeline(std::move(list), tick, ringCapacity > 0 ? ringCapacity : 64);
+}
+
+void pipeline_destroy(void* p) {
+    delete static_cast<pipeline::Pipeline*>(p);
+}
+
+void pipeline_start(void* p) {
+    static_cast<pipeline::Pipeline*>(p)->start();
+}
+
+void pipeline_stop(void* p) {
+    static_cast<pipeline::Pipeline*>(p)->stopAll();
+}
+
+// Fills values[k] with the newest reading of sensor k (0 before the first)
+// and ages[k] with how old it is now; returns the tick that published it.
+unsigned long long pipeline_latest(void* p, long long* values, double* ages, int n) {
+    pipeline::Snapshot s = static_cast<pipeline::Pipeline*>(p)->latest();
+    int64_t now = pipeline::nowNs();
+    for (int k = 0; k < n && k < int(s.samples.size()); k++)
+    {
+        values[k] = s.samples[k].value;
+        ages[k] = s.samples[k].seq ? (now - s.samples[k].stamp) * 1e-9 : -1.0;
+    }
+    return s.tick;
+}
+
+// Per sensor 6 values: produced, dropped, delivered, latency p50, p99 and max;
+// then the aggregator's ticks and tick jitter p50, p99 and max. Returns the
+// number of values written (at most n). Valid after pipeline_stop.
+int pipeline_stats(void* p, double* out, int n) {
+    const pipeline::Stats& st = static_cast<pipeline::Pipeline*>(p)->stats();
+    std::vector<double> v;
+    for (const auto& s : st.sensors)
+    {
+        v.insert(v.end(), {double(s.produced), double(s.dropped), double(s.latency.count()),
+                           s.latency.percentile(0.5) * 1e-9, s.latency.percentile(0.99) * 1e-9, s.latency.max() * 1e-9});
+    }
+    v.insert(v.end(), {double(st.ticks), st.jitter.percentile(0.5) * 1e-9, st.jitter.percentile(0.99) * 1e-9,
+                       st.jitter.max() * 1e-9});
+    int count = std::min<int>(n, v.size());
+    std::copy(v.begin(), v.begin() + count, out);
+    return count;
+}
+
+}
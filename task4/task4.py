@@ -4,6 +4,7 @@ from queue import Queue
 import argparse
 import threading
 import logging
+from pipeline import Pipeline
 
 class Sensor:
 
@@ -66,6 +67,7 @@ if __name__ == '__main__':
     parser.add_argument('--name', type=int, help='Name of camera', default=0)
     parser.add_argument('--resolution', type=str, help='Resolution', default='640x480')
     parser.add_argument('--frequency', type=float, help='frequency', default=0.001)
+    parser.add_argument('--native', action='store_true', help='Read the sensors through the C++ pipeline (make libpipeline.so)')
 
     args = parser.parse_args()
 
@@ -79,23 +81,31 @@ if __name__ == '__main__':
     resol.append(int(resolut[1]))
 
     cam = SensorCam(name, resol)
-    sen1 = SensorX(1)
-    sen2 = SensorX(0.1)
-    sen3 = SensorX(0.01)
-
-    qu1 = Queue(2)
-    qu2 = Queue(2)
-    qu3 = Queue(2)
     quVid = Queue(2)
-
     thread_video = threading.Thread(target=push, args=(cam, quVid, frequency), daemon=True)
-    thread_sen1 = threading.Thread(target=push, args=(sen1, qu1, 0,), daemon=True)
-    thread_sen2 = threading.Thread(target=push, args=(sen2, qu2, 0,), daemon=True)
-    thread_sen3 = threading.Thread(target=push, args=(sen3, qu3, 0,), daemon=True)
 
-    thread_sen1.start()
-    thread_sen2.start()
-    thread_sen3.start()
+    # --native: the three sensors run in C++ threads (pipeline.hpp) and the
+    # loop below only copies their latest values, it never waits for them
+    native = None
+    if args.native:
+        native = Pipeline([1, 0.1, 0.01])
+        native.start()
+    else:
+        sen1 = SensorX(1)
+        sen2 = SensorX(0.1)
+        sen3 = SensorX(0.01)
+
+        qu1 = Queue(2)
+        qu2 = Queue(2)
+        qu3 = Queue(2)
+
+        thread_sen1 = threading.Thread(target=push, args=(sen1, qu1, 0,), daemon=True)
+        thread_sen2 = threading.Thread(target=push, args=(sen2, qu2, 0,), daemon=True)
+        thread_sen3 = threading.Thread(target=push, args=(sen3, qu3, 0,), daemon=True)
+
+        thread_sen1.start()
+        thread_sen2.start()
+        thread_sen3.start()
     thread_video.start()
 
     window = WindowImage(frequency)
@@ -118,14 +128,17 @@ if __name__ == '__main__':
                     logging.error(Exception('Unable to read the input.'))
                     exit(1)
 
-            if not qu1.empty():
-                Sensor1 = qu1.get_nowait()
+            if native is not None:
+                (Sensor1, Sensor2, Sensor3), _, _ = native.latest()
+            else:
+                if not qu1.empty():
+                    Sensor1 = qu1.get_nowait()
 
-            if not qu2.empty():
-                Sensor2 = qu2.get_nowait()
+                if not qu2.empty():
+                    Sensor2 = qu2.get_nowait()
 
-            if not qu3.empty():
-                Sensor3 = qu3.get_nowait()    
+                if not qu3.empty():
+                    Sensor3 = qu3.get_nowait()    
         except Exception as error:
             logging.error(error)
         try:      
@@ -0,0 +1,143 @@
+#include <iostream>
+#include <iomanip>
+#include <atomic>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/resource.h>
+#include "frame_pipeline.hpp"
+
+// Synthetic task5 workload through frame_pipeline::Pipeline with 1, 2, 4, ...
+// workers, then through task5.py's structure (read everything, process with
+// the same workers, write in id order at the end). The per-frame stage is a
+// 3x3 box blur repeated `passes` times; every third frame takes twice as
+// long, so frames finish out of order like model inference does. The sink
+// folds every output frame into a checksum, which must be the same for every
+// run.
+// usage: frame_bench [frames] [width] [height] [passes] [maxWorkers]
+
+void blur(frame_pipeline::Frame& f, int passes) {
+    int w = f.width, h = f.height, c = f.channels;
+    f.scratch.resize(f.data.size());
+    for (int p = 0; p < passes; p++)
+    {
+        const uint8_t* in = f.data.data();
+        uint8_t* out = f.scratch.data();
+        for (int y = 0; y < h; y++)
+            for (int x = 0; x < w; x++)
+                for (int k = 0; k < c; k++)
+                {
+                    int s = 0;
+                    for (int dy = -1; dy <= 1; dy++)
+                        for (int dx = -1; dx <= 1; dx++)
+                        {
+                            int yy = std::clamp(y + dy, 0, h - 1), xx = std::clamp(x + dx, 0, w - 1);
+                            s += in[(size_t(yy) * w + xx) * c + k];
+                        }
+                    out[(size_t(y) * w + x) * c + k] = uint8_t(s / 9);
+                }
+        f.data.swap(f.scratch);
+    }
+}
+
+struct Checksum {
+    uint64_t value = 1469598103934665603ull;
+    uint64_t last = 0;
+    bool ordered = true;
+    void add(const frame_pipeline::Frame& f) {
+        ordered &= f.id == 0 || f.id == last + 1;
+        last = f.id;
+        for (size_t k = 0; k < f.data.size(); k += 61)
+            value = (value ^ f.data[k]) * 1099511628211ull;
+    }
+};
+
+// task5.py: every frame is read before any is processed, the output is
+// written once the last one is done.
+frame_pipeline::Stats batch(frame_pipeline::Source& source, const frame_pipeline::Stage& stage,
+                            const frame_pipeline::Sink& sink, int workers) {
+    using frame_pipeline::Clock;
+    frame_pipeline::Stats st;
+    auto start = Clock::now();
+    std::vector<std::unique_ptr<frame_pipeline::Frame>> frames;
+    for (;;)
+    {
+        std::unique_ptr<frame_pipeline::Frame> f(new frame_pipeline::Frame());
+        if (!source.read(*f))
+            break;
+        f->id = frames.size();
+        f->readAt = Clock::now();
+        frames.push_back(std::move(f));
+    }
+    std::atomic<size_t> next{0};
+    std::vector<std::thread> pool;
+    for (int w = 0; w < workers; w++)
+        pool.emplace_back([&] {
+            for (size_t k = next++; k < frames.size(); k = next++)
+                stage(*frames[k]);
+        });
+    for (auto& t : pool)
+        t.join();
+    for (const auto& f : frames)
+    {
+        sink(*f);
+        auto now = Clock::now();
+        if (st.frames == 0)
+            st.firstFrame = std::chrono::duration<double>(now - start).count();
+        st.latency.push_back(std::chrono::duration<double>(now - f->readAt).count());
+        st.frames++;
+        st.peakBytes += f->bytes();
+    }
+    st.peakInFlight = frames.size();
+    st.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    return st;
+}
+
+int main(int argc, char const *argv[])
+{
+    uint64_t frames = argc > 1 ? std::atol(argv[1]) : 300;
+    int width = argc > 2 ? std::atoi(argv[2]) : 640;
+    int height = argc > 3 ? std::atoi(argv[3]) : 480;
+    int passes = argc > 4 ? std::atoi(argv[4]) : 2;
+    int maxWorkers = argc > 5 ? std::atoi(argv[5]) : 8;
+    frame_pipeline::Stage stage = [passes](frame_pipeline::Frame& f) { blur(f, f.id % 3 == 0 ? 2 * passes : passes); };
+
+    std::cout << frames << " frames " << width << 'x' << height << "x3, " << passes << " blur passes, "
+              << std::thread::hardware_concurrency() << " hardware threads" << std::endl;
+    std::cout << std::setw(10) << "mode" << std::setw(9) << "workers" << std::setw(9) << "fps" << std::setw(12)
+              << "first, ms" << std::setw(11) << "p50, ms" << std::setw(11) << "p99, ms" << std::setw(11) << "max, ms"
+              << std::setw(10) << "frames" << std::setw(10) << "MB" << "  checksum" << std::endl;
+    auto report = [&](const std::string& mode, int workers, const frame_pipeline::Stats& st, const Checksum& sum) {
+        std::cout << std::setw(10) << mode << std::setw(9) << workers << std::fixed << std::setprecision(1)
+                  << std::setw(9) << st.fps() << std::setw(12) << st.firstFrame * 1e3 << std::setw(11)
+                  << st.percentile(0.5) * 1e3 << std::setw(11) << st.percentile(0.99) * 1e3 << std::setw(11)
+                  << st.percentile(1.0) * 1e3 << std::setw(10) << st.peakInFlight << std::setw(10)
+                  << st.peakBytes / 1048576.0 << "  " << std::hex << sum.value << std::dec
+                  << (sum.ordered && st.frames == frames ? "" : "  OUT OF ORDER") << std::endl;
+    };
+
+    uint64_t reference = 0;
+    bool ok = true;
+    for (int workers = 1; workers <= maxWorkers; workers *= 2)
+    {
+        frame_pipeline::SyntheticSource source(frames, width, height);
+        frame_pipeline::Pipeline pipe({workers, 0});
+        Checksum sum;
+        frame_pipeline::Stats st = pipe.run(source, stage, [&](const frame_pipeline::Frame& f) { sum.add(f); });
+        report("stream", workers, st, sum);
+        if (workers == 1)
+            reference = sum.value;
+        ok &= sum.ordered && sum.value == reference;
+    }
+    frame_pipeline::SyntheticSource source(frames, width, height);
+    Checksum sum;
+    frame_pipeline::Stats st = batch(source, stage, [&](const frame_pipeline::Frame& f) { sum.add(f); }, maxWorkers);
+    report("batch", maxWorkers, st, sum);
+    ok &= sum.ordered && sum.value == reference;
+
+    rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+    std::cout << "peak RSS of the process " << ru.ru_maxrss / 1024 << " MB" << std::endl;
+    return ok ? 0 : 1;
+}
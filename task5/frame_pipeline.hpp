@@ -0,0 +1,235 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Streaming version of the task5 frame loop. task5.py reads the whole video
+// into a Queue, processes it and then sorts the frames by id, so memory grows
+// with the video and nothing comes out before the last frame is read.
+//
+// Here every frame lives in one of `capacity` buffers. The pool is created
+// on demand and never grows past `capacity`, and buffers are reused once the
+// sink has taken their frame.
+//
+// The reader blocks when no buffer is free. Buffers only come back at the
+// other end of the pipeline, in order, so this bounds the frames queued,
+// being processed and waiting to be reordered, all together.
+//
+// `workers` threads run the per-frame stage in any order. The reorder
+// buffer is a ring of `capacity` slots, and frame id goes to slot
+// id % capacity. The frames in flight always have consecutive ids, at most
+// capacity apart, so two of them can never share a slot.
+//
+// The sink runs on the calling thread. It gets frame k as soon as frames
+// 0..k are done, so output starts with the first finished frame.
+namespace frame_pipeline {
+
+using Clock = std::chrono::steady_clock;
+
+struct Frame {
+    uint64_t id = 0;
+    int width = 0, height = 0, channels = 0;
+    std::vector<uint8_t> data;      // the stage leaves its output here
+    std::vector<uint8_t> scratch;   // for out-of-place stages, kept with the buffer
+    Clock::time_point readAt;       // when the source returned it
+
+    size_t bytes() const {
+        return data.capacity() + scratch.capacity();
+    }
+};
+
+class Source {
+public:
+    virtual ~Source() = default;
+    // Fills `f` (whose buffers may hold a previous frame); false at the end.
+    virtual bool read(Frame& f) = 0;
+};
+
+// Deterministic frames for tests and benchmarks: a gradient that moves with
+// the frame number, no video file or OpenCV needed.
+class SyntheticSource : public Source {
+private:
+    uint64_t count, next = 0;
+    int width, height, channels;
+public:
+    SyntheticSource(uint64_t count, int width, int height, int channels = 3)
+        : count(count), width(width), height(height), channels(channels) {}
+
+    bool read(Frame& f) override {
+        if (next == count)
+            return false;
+        f.width = width;
+        f.height = height;
+        f.channels = channels;
+        f.data.resize(size_t(width) * height * channels);
+        uint8_t* p = f.data.data();
+        for (int y = 0; y < height; y++)
+            for (int x = 0; x < width; x++)
+                for (int c = 0; c < channels; c++)
+                    *p++ = uint8_t(x + 2 * y + 3 * c + next);
+        next++;
+        return true;
+    }
+};
+
+using Stage = std::function<void(Frame&)>;
+using Sink = std::function<void(const Frame&)>;
+
+struct Options {
+    int workers = 1;
+    size_t capacity = 0;        // frames in flight, 0 = 2 * workers + 2
+};
+
+struct Stats {
+    uint64_t frames = 0;
+    double seconds = 0.0;           // whole run, start to the last thread joined
+    double firstFrame = 0.0;        // start to the first frame handed to the sink
+    size_t peakInFlight = 0;        // most buffers in use at once
+    size_t peakBytes = 0;           // frame memory of the pool at its largest
+    std::vector<double> latency;    // per frame, read -> sink, seconds
+
+    double fps() const {
+        return seconds > 0 ? frames / seconds : 0.0;
+    }
+    // p-quantile of the latencies, p in [0, 1]
+    double percentile(double p) const {
+        if (latency.empty())
+            return 0.0;
+        std::vector<double> v = latency;
+        size_t k = size_t(p * (v.size() - 1));
+        std::nth_element(v.begin(), v.begin() + k, v.end());
+        return v[k];
+    }
+};
+
+class Pipeline {
+private:
+    Options opt;
+    std::vector<std::unique_ptr<Frame>> pool;
+    std::vector<Frame*> freeFrames;
+    std::deque<Frame*> queued;              // read, waiting for a worker
+    std::vector<Frame*> done;               // reorder ring, slot id % capacity
+    bool readerFinished = false;
+    uint64_t readCount = 0;
+    std::mutex mut;
+    std::condition_variable freeCv, queueCv, doneCv;
+
+    Frame* acquire() {
+        std::unique_lock<std::mutex> lock(mut);
+        if (freeFrames.empty() && pool.size() < opt.capacity)
+        {
+            pool.emplace_back(new Frame());
+            return pool.back().get();
+        }
+        freeCv.wait(lock, [this] { return !freeFrames.empty(); });
+        Frame* f = freeFrames.back();
+        freeFrames.pop_back();
+        return f;
+    }
+
+    void read(Source& source) {
+        for (uint64_t id = 0;; id++)
+        {
+            Frame* f = acquire();
+            bool ok = source.read(*f);
+            std::lock_guard<std::mutex> lock(mut);
+            if (!ok)
+            {
+                freeFrames.push_back(f);
+                readerFinished = true;
+                readCount = id;
+                break;
+            }
+            f->id = id;
+            f->readAt = Clock::now();
+            queued.push_back(f);
+            queueCv.notify_one();
+        }
+        queueCv.notify_all();
+        doneCv.notify_all();
+    }
+
+    void work(const Stage& stage) {
+        for (;;)
+        {
+            Frame* f;
+            {
+                std::unique_lock<std::mutex> lock(mut);
+                queueCv.wait(lock, [this] { return !queued.empty() || readerFinished; });
+                if (queued.empty())
+                    return;
+                f = queued.front();
+                queued.pop_front();
+            }
+            stage(*f);
+            std::lock_guard<std::mutex> lock(mut);
+            done[f->id % opt.capacity] = f;
+            doneCv.notify_all();
+        }
+    }
+
+public:
+    explicit Pipeline(Options o) : opt(o) {
+        opt.workers = std::max(opt.workers, 1);
+        if (opt.capacity == 0)
+            opt.capacity = 2 * opt.workers + 2;
+        // fewer buffers than workers would leave workers idle
+        opt.capacity = std::max<size_t>(opt.capacity, opt.workers);
+    }
+
+    // Streams every frame of `source` through `stage` into `sink`, in order.
+    Stats run(Source& source, const Stage& stage, const Sink& sink) {
+        pool.clear();
+        freeFrames.clear();
+        queued.clear();
+        done.assign(opt.capacity, nullptr);
+        readerFinished = false;
+        readCount = 0;
+
+        Stats st;
+        auto start = Clock::now();
+        std::thread reader([&] { read(source); });
+        std::vector<std::thread> workers;
+        for (int w = 0; w < opt.workers; w++)
+            workers.emplace_back([&] { work(stage); });
+
+        for (uint64_t next = 0;; next++)
+        {
+            Frame* f;
+            {
+                std::unique_lock<std::mutex> lock(mut);
+                doneCv.wait(lock, [&] { return done[next % opt.capacity] || (readerFinished && next == readCount); });
+                f = done[next % opt.capacity];
+                if (!f)
+                    break;
+                done[next % opt.capacity] = nullptr;
+                st.peakInFlight = std::max(st.peakInFlight, pool.size() - freeFrames.size());
+            }
+            sink(*f);
+            auto now = Clock::now();
+            if (next == 0)
+                st.firstFrame = std::chrono::duration<double>(now - start).count();
+            st.latency.push_back(std::chrono::duration<double>(now - f->readAt).count());
+            st.frames++;
+            std::lock_guard<std::mutex> lock(mut);
+            freeFrames.push_back(f);
+            freeCv.notify_one();
+        }
+        reader.join();
+        for (auto& t : workers)
+            t.join();
+        st.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        for (const auto& f : pool)
+            st.peakBytes += f->bytes();
+        return st;
+    }
+};
+
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+
+// Decides on which iterations the sweep also computes max|cur-prev|.
+// Fixed mode checks every `interval` iterations (the old behaviour).
+// Adaptive mode estimates the per-iteration decay rate from the last two
+// checks, predicts how many iterations remain until `accuracy` and schedules
+// the next check at half of that, so the interval shrinks towards 1 as the
+// solver gets close and the run stops a few iterations after crossing it.
+class CheckPolicy {
+private:
+    int interval;
+    int maxInterval;
+    bool adaptive;
+    double accuracy;
+    int nextCheck;
+    int lastIter = 0;
+    double lastError = 0.0;
+public:
+    CheckPolicy(int interval, bool adaptive, double accuracy, int maxInterval = 10000)
+        : interval(std::max(interval, 1)), maxInterval(std::max(maxInterval, 1)),
+          adaptive(adaptive), accuracy(accuracy), nextCheck(this->interval) {}
+
+    // iter is the number of sweeps done after the current one (1-based)
+    bool due(int iter) const {
+        return iter >= nextCheck;
+    }
+
+    void update(int iter, double error) {
+        int step = interval;
+        if (adaptive && lastIter > 0 && error > 0.0 && error < lastError) {
+            double rate = std::pow(error / lastError, 1.0 / (iter - lastIter));
+            double remaining = std::log(accuracy / error) / std::log(rate);
+            if (remaining <= 1.0)
+                step = 1;
+            else
+                step = static_cast<int>(std::min<double>(remaining * 0.5 + 1.0, maxInterval));
+        }
+        lastIter = iter;
+        lastError = error;
+        nextCheck = iter + step;
+    }
+
+    int next() const {
+        return nextCheck;
+    }
+};
@@ -0,0 +1,377 @@
+#include <iostream>
+#include <boost/program_options.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <omp.h>
+#include "../check_policy.hpp"
+#include "solvers.hpp"
+#include "stencil.hpp"
+#include "scenario.hpp"
+#include "../../common/grid_alloc.hpp"
+#include "../../common/grid_io.hpp"
+namespace opt = boost::program_options;
+
+// Many small task6 solves on one machine. Every line of the instance list
+// holds task.cpp options for one solve (size, accuracy, solver, boundary,
+// source); '#' starts a comment:
+//
+//   --cellsCount 128 --accuracy 1e-6
+//   --cellsCount 384 --solver sor --boundary.top "dirichlet constant 40"
+//
+// ensemble mode: `threads` workers each take the next instance (the most
+// expensive first) and run it alone. An instance runs in slices, one slice
+// up to its next error check. Before every slice it takes threads/left
+// threads, where left counts the instances not finished yet. While the
+// queue is full that is one thread. As instances converge and the queue
+// drains, the workers left over exit and the running solves widen into
+// their threads.
+// back-to-back mode: the same instances one after another, each on all
+// threads, which is what a loop over task.cpp runs does.
+// Both modes run the same sweeps, so every instance ends with the same
+// field bits whatever the thread counts were.
+// usage: ensemble --instances list.txt [--threads T] [--mode both|ensemble|serial] [--output prefix]
+
+struct Instance {
+    int line;
+    int N;
+    double accuracy;
+    int countIter;
+    int checkInterval;
+    bool adaptive;
+    std::string solver;
+    double omega;
+    Scenario scenario;
+    double cost;        // estimated work, the ensemble starts the largest first
+
+    // state of a running solve
+    grid_alloc::unique_array<double> a, b, f;
+    double* prev = nullptr;     // current field; Jacobi sweeps prev -> cur
+    double* cur = nullptr;
+    Scenario::Kernels<double> edges;
+    std::unique_ptr<CheckPolicy> check;
+    std::unique_ptr<Multigrid<double>> mg;
+    int iter = 0;
+    double error = 1.0;
+    int width = 0;              // most threads a slice got
+
+    // result of the last run
+    double seconds = 0.0;       // from the start of the run to convergence
+    double residual = 0.0;
+    uint64_t hash = 0;
+
+    void start() {
+        size_t len = size_t(N) * N;
+        a = grid_alloc::make_array<double>(len);
+        b = grid_alloc::make_array<double>(len);
+        stencil::CornerInterpolated::init<2>(a.get(), stencil::Extents<>(N, N), 1);
+        stencil::CornerInterpolated::init<2>(b.get(), stencil::Extents<>(N, N), 1);
+        scenario.initBoundary(a.get(), N, N);
+        scenario.initBoundary(b.get(), N, N);
+        std::string err;
+        f = nullptr;
+        scenario.makeSource(f, N, N, err);     // checked when the list was read
+        edges = scenario.compile<double>(N, N);
+        prev = a.get();
+        cur = b.get();
+        // the check intervals of task.cpp's solve()
+        int interval = solver == "jacobi" ? checkInterval : std::min(checkInterval, solver == "sor" ? 10 : 1);
+        check.reset(new CheckPolicy(interval, adaptive, accuracy));
+        mg.reset(solver == "multigrid" ? new Multigrid<double>(N) : nullptr);
+        iter = 0;
+        error = 1.0;
+        width = 0;
+    }
+
+    // Frees the grids, writing the field first when prefix is set.
+    void finish(double elapsed, const std::string& prefix) {
+        seconds = elapsed;
+        residual = jacobiResidual<double>(prev, f.get(), N);
+        hash = 1469598103934665603ull;
+        const unsigned char* p = reinterpret_cast<const unsigned char*>(prev);
+        for (size_t k = 0; k < size_t(N) * N * sizeof(double); k++)
+            hash = (hash ^ p[k]) * 1099511628211ull;
+        if (!prefix.empty())
+            grid_io::writeGrid(prefix + "_" + std::to_string(line) + ".grid", prev, N, N);
+        a = nullptr;
+        b = nullptr;
+        f = nullptr;
+        mg = nullptr;
+    }
+};
+
+template <bool WithError>
+double jacobiRow(double* cur, const double* prev, const double* f, int N, int i) {
+    size_t row = size_t(i) * N;
+    if (f)
+        return stencil::updateRange<stencil::Point5, WithError, true, true, double, double>(cur, prev, f, row, 1, N-1, N, 0);
+    return stencil::updateRange<stencil::Point5, WithError, true, false, double, double>(cur, prev, f, row, 1, N-1, N, 0);
+}
+
+// Runs `in` up to its next error check on `width` threads (one parallel
+// region for the slice, a barrier per sweep) and returns true once it has
+// converged, diverged or used up its iterations.
+bool advance(Instance& in, int width) {
+    int N = in.N;
+    int steps = std::max(1, std::min(in.check->next(), in.countIter) - in.iter);
+    const double* f = in.f.get();
+    double error = 0.0;
+    if (in.mg)
+    {
+        // the V-cycle has no row-split form, it stays on its worker's thread
+        in.width = 1;
+        for (int s = 0; s < steps; s++)
+            error = in.mg->cycle(in.prev, f, s == steps - 1);
+    }
+    else
+    {
+        in.width = std::max(in.width, width);
+        bool sor = in.solver == "sor";
+        double omega = in.omega;
+        #pragma omp parallel num_threads(width)
+        for (int s = 0; s < steps; s++)
+        {
+            bool last = s == steps - 1;
+            double* dst = sor ? in.prev : s % 2 ? in.prev : in.cur;
+            const double* src = s % 2 ? in.cur : in.prev;
+            for (int color = 0; color < (sor ? 2 : 1); color++)
+            {
+                #pragma omp for schedule(static) reduction(max:error)
+                for (int i = 1; i < N-1; i++)
+                {
+                    if (sor)
+                        error = stencil::maxChange(error, last ? sorRows<true, double>(dst, f, N, omega, color, i, i+1)
+                                                                : sorRows<false, double>(dst, f, N, omega, color, i, i+1));
+                    else
+                        error = stencil::maxChange(error, last ? jacobiRow<true>(dst, src, f, N, i) : jacobiRow<false>(dst, src, f, N, i));
+                }
+            }
+            if (!in.edges.empty())
+            {
+                #pragma omp single
+                in.edges.apply(dst, N, N);
+            }
+        }
+        if (!sor && steps % 2)
+            std::swap(in.prev, in.cur);
+    }
+    in.iter += steps;
+    in.error = error;
+    in.check->update(in.iter, error);
+    return in.error <= in.accuracy || in.iter >= in.countIter || !std::isfinite(in.error);
+}
+
+double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Every instance on all threads, in list order; returns the wall time.
+double runBackToBack(std::vector<Instance>& list, int threads, const std::string& prefix) {
+    auto start = std::chrono::steady_clock::now();
+    for (Instance& in : list)
+    {
+        in.start();
+        while (!advance(in, threads))
+        {
+        }
+        in.finish(secondsSince(start), prefix);
+    }
+    return secondsSince(start);
+}
+
+double runEnsemble(std::vector<Instance>& list, int threads, const std::string& prefix) {
+    std::vector<size_t> order(list.size());
+    for (size_t k = 0; k < order.size(); k++)
+        order[k] = k;
+    std::stable_sort(order.begin(), order.end(), [&](size_t x, size_t y) { return list[x].cost > list[y].cost; });
+    std::atomic<size_t> next{0};
+    std::atomic<int> left{int(list.size())};
+    auto start = std::chrono::steady_clock::now();
+    auto worker = [&]() {
+        // parallel regions without num_threads (the multigrid change check in
+        // vecops) stay on this worker instead of starting a full team each
+        omp_set_num_threads(1);
+        for (size_t k = next++; k < order.size(); k = next++)
+        {
+            Instance& in = list[order[k]];
+            in.start();
+            while (!advance(in, std::max(1, threads / left.load())))
+            {
+            }
+            in.finish(secondsSince(start), prefix);
+            left--;
+        }
+    };
+    std::vector<std::thread> pool;
+    for (int t = 0; t < threads; t++)
+        pool.emplace_back(worker);
+    for (auto& th : pool)
+        th.join();
+    return secondsSince(start);
+}
+
+// Parses the instance list; on error prints it with the line number and returns false.
+bool readInstances(const std::string& filename, std::vector<Instance>& list) {
+    std::ifstream in(filename);
+    if (!in.is_open())
+    {
+        std::cerr << "Unable to open file " << filename << std::endl;
+        return false;
+    }
+    opt::options_description desc("Instance");
+    desc.add_options()
+        ("accuracy",opt::value<double>()->default_value(1e-6),"Accuracy")
+        ("cellsCount",opt::value<int>()->default_value(128),"Matrix size")
+        ("iterCount",opt::value<int>()->default_value(1000000),"Count of itteration")
+        ("checkInterval",opt::value<int>()->default_value(100),"Iterations between error checks")
+        ("adaptive","Choose the check interval from the observed convergence rate")
+        ("solver",opt::value<std::string>()->default_value("jacobi"),"jacobi, sor or multigrid")
+        ("omega",opt::value<double>()->default_value(0.0),"SOR relaxation factor, 0 = optimal for the grid size");
+    Scenario::addOptions(desc);
+    std::string text;
+    for (int line = 1; std::getline(in, text); line++)
+    {
+        text = text.substr(0, text.find('#'));
+        std::vector<std::string> args = opt::split_unix(text);
+        if (args.empty())
+            continue;
+        Instance inst;
+        std::string err;
+        try
+        {
+            opt::variables_map vm;
+            opt::store(opt::command_line_parser(args).options(desc).run(), vm);
+            opt::notify(vm);
+            inst.line = line;
+            inst.N = vm["cellsCount"].as<int>();
+            inst.accuracy = vm["accuracy"].as<double>();
+            inst.countIter = vm["iterCount"].as<int>();
+            inst.checkInterval = vm["checkInterval"].as<int>();
+            inst.adaptive = vm.count("adaptive") > 0;
+            inst.solver = vm["solver"].as<std::string>();
+            inst.omega = vm["omega"].as<double>();
+            if (inst.omega <= 0.0)
+                inst.omega = optimalOmega(inst.N);
+            grid_alloc::unique_array<double> f;
+            if (inst.N < 4)
+                err = "cellsCount must be at least 4";
+            else if (inst.solver != "jacobi" && inst.solver != "sor" && inst.solver != "multigrid")
+                err = "unknown solver " + inst.solver;
+            else if (inst.scenario.fromOptions(vm, err) && inst.scenario.makeSource(f, inst.N, inst.N, err) &&
+                     inst.solver == "multigrid" && !inst.scenario.allDirichlet())
+                err = "multigrid needs Dirichlet edges";
+        }
+        catch (const std::exception& e)
+        {
+            err = e.what();
+        }
+        if (!err.empty())
+        {
+            std::cerr << filename << ':' << line << ": " << err << std::endl;
+            return false;
+        }
+        // sweeps to converge grow like N^2 for Jacobi, N for SOR, and stay flat for multigrid
+        double n = inst.N;
+        double sweeps = inst.solver == "jacobi" ? n * n : inst.solver == "sor" ? 4 * n : 40.0;
+        inst.cost = n * n * sweeps * std::log(1.0 / std::min(inst.accuracy, 0.5));
+        list.push_back(std::move(inst));
+    }
+    if (list.empty())
+    {
+        std::cerr << filename << ": no instances" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char const *argv[])
+{
+    opt::options_description desc("Argument");
+    desc.add_options()
+        ("instances",opt::value<std::string>(),"Instance list, one line of task.cpp options per solve")
+        ("threads",opt::value<int>()->default_value(0),"Threads, 0 = all hardware threads")
+        ("mode",opt::value<std::string>()->default_value("both"),"ensemble, serial (back to back, each on all threads) or both")
+        ("output",opt::value<std::string>()->default_value(""),"Write every final field as <prefix>_<line>.grid")
+        ("verbose","Print every instance")
+        ("help","help");
+    opt::variables_map vm;
+    opt::store(opt::parse_command_line(argc, argv, desc), vm);
+    opt::notify(vm);
+    if (vm.count("help") || !vm.count("instances")) {
+        std::cout << desc << "\n";
+        return 1;
+    }
+    std::string mode = vm["mode"].as<std::string>();
+    if (mode != "both" && mode != "ensemble" && mode != "serial")
+    {
+        std::cerr << "Unknown mode " << mode << std::endl;
+        return 1;
+    }
+    int threads = vm["threads"].as<int>();
+    if (threads <= 0)
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    std::string prefix = vm["output"].as<std::string>();
+    std::vector<Instance> list;
+    if (!readInstances(vm["instances"].as<std::string>(), list))
+        return 1;
+    std::cout << list.size() << " instances, " << threads << " threads" << std::endl;
+
+    double serialTime = 0.0, ensembleTime = 0.0;
+    std::vector<uint64_t> serialHash;
+    if (mode != "ensemble")
+    {
+        serialTime = runBackToBack(list, threads, mode == "both" ? "" : prefix);
+        for (const Instance& in : list)
+            serialHash.push_back(in.hash);
+    }
+    if (mode != "serial")
+        ensembleTime = runEnsemble(list, threads, prefix);
+
+    if (vm.count("verbose"))
+    {
+        std::cout << std::setw(6) << "line" << std::setw(6) << "N" << std::setw(11) << "solver" << std::setw(11)
+                  << "iterations" << std::setw(12) << "error" << std::setw(12) << "residual" << std::setw(9)
+                  << "threads" << std::setw(12) << "done at, s" << std::endl;
+        for (const Instance& in : list)
+            std::cout << std::setw(6) << in.line << std::setw(6) << in.N << std::setw(11) << in.solver << std::setw(11)
+                      << in.iter << std::setw(12) << std::scientific << std::setprecision(3) << in.error
+                      << std::setw(12) << in.residual << std::defaultfloat << std::setw(9) << in.width
+                      << std::setw(12) << std::fixed << std::setprecision(3) << in.seconds << std::defaultfloat
+                      << std::endl;
+    }
+    std::cout << std::setw(14) << "mode" << std::setw(10) << "wall, s" << std::setw(14) << "solves/hour" << std::endl;
+    if (mode != "ensemble")
+        std::cout << std::setw(14) << "back-to-back" << std::setw(10) << std::fixed << std::setprecision(3) << serialTime
+                  << std::setw(14) << std::setprecision(0) << list.size() / serialTime * 3600 << std::endl;
+    if (mode != "serial")
+        std::cout << std::setw(14) << "ensemble" << std::setw(10) << std::fixed << std::setprecision(3) << ensembleTime
+                  << std::setw(14) << std::setprecision(0) << list.size() / ensembleTime * 3600 << std::endl;
+    std::cout << std::defaultfloat;
+    bool diverged = false;
+    for (const Instance& in : list)
+        if (!std::isfinite(in.error))
+        {
+            std::cerr << "line " << in.line << ": " << in.solver << " diverged at iteration " << in.iter << std::endl;
+            diverged = true;
+        }
+    if (diverged)
+        return 1;
+    if (mode == "both")
+    {
+        size_t same = 0;
+        for (size_t k = 0; k < list.size(); k++)
+            same += list[k].hash == serialHash[k];
+        std::cout << "speedup " << std::setprecision(3) << serialTime / ensembleTime << ", " << same << " of " << list.size()
+                  << " fields identical to back-to-back" << std::endl;
+        return same == list.size() ? 0 : 1;
+    }
+    return 0;
+}
@@ -0,0 +1,74 @@
+#include <iostream>
+#include <iomanip>
+#include <memory>
+#include <vector>
+#include <cmath>
+#include <thread>
+#include <omp.h>
+#include "solvers.hpp"
+#include "../../common/task_graph.hpp"
+
+// Per-iteration cost of a Jacobi sweep launched as a fresh OpenMP parallel
+// loop every iteration against the same sweeps recorded once into a
+// TaskGraph and replayed (barriers only). usage: graph_bench [threads] [iters]
+int main(int argc, char const *argv[])
+{
+    int threads = argc > 1 ? std::atoi(argv[1]) : std::thread::hardware_concurrency();
+    int iters = argc > 2 ? std::atoi(argv[2]) : 2000;
+    iters += iters % 2;
+    omp_set_num_threads(threads);
+    std::cout << threads << " threads, " << iters << " sweeps" << std::endl;
+    std::cout << std::setw(6) << "N" << std::setw(16) << "omp, us/iter" << std::setw(18) << "graph, us/iter"
+              << std::setw(10) << "speedup" << std::endl;
+    for (int N : {128, 192, 256, 384, 512})
+    {
+        std::vector<double> a(size_t(N) * N, 0.0), b(size_t(N) * N, 0.0);
+        for (int k = 0; k < N; k++)
+            a[k] = b[k] = 10.0;
+        double* prev = a.data();
+        double* cur = b.data();
+
+        double t = omp_get_wtime();
+        double errOmp = 0.0;
+        for (int it = 0; it < iters; it++)
+        {
+            bool last = it == iters - 1;
+            double err = 0.0;
+            #pragma omp parallel for schedule(static) reduction(max:err)
+            for (int i = 1; i < N-1; i++)
+            {
+                if (last)
+                    err = std::fmax(err, sweepRows<true, double>(cur, prev, N, i, i+1));
+                else
+                    sweepRows<false, double>(cur, prev, N, i, i+1);
+            }
+            errOmp = err;
+            std::swap(prev, cur);
+        }
+        double tOmp = omp_get_wtime() - t;
+
+        std::fill(a.begin() + N, a.end(), 0.0);
+        std::fill(b.begin() + N, b.end(), 0.0);
+        prev = a.data();
+        cur = b.data();
+        TaskGraph graph(threads);
+        double errGraph = 0.0;
+        t = omp_get_wtime();
+        for (int s = 0; s < iters; s++)
+        {
+            double* dst = s % 2 ? prev : cur;
+            const double* src = s % 2 ? cur : prev;
+            if (s == iters - 1)
+                graph.addReduceMax(N-2, [=](size_t b, size_t e) { return sweepRows<true, double>(dst, src, N, b+1, e+1); }, &errGraph);
+            else
+                graph.addParallel(N-2, [=](size_t b, size_t e) { sweepRows<false, double>(dst, src, N, b+1, e+1); });
+        }
+        graph.replay();
+        double tGraph = omp_get_wtime() - t;
+
+        std::cout << std::setw(6) << N << std::fixed << std::setprecision(2) << std::setw(16) << tOmp / iters * 1e6
+                  << std::setw(18) << tGraph / iters * 1e6 << std::setw(10) << tOmp / tGraph
+                  << (errOmp == errGraph ? "" : "  MISMATCH") << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,306 @@
+#pragma once
+#include <string>
+#include <sstream>
+#include <vector>
+#include <cmath>
+#include <boost/program_options.hpp>
+#include "../../common/grid_alloc.hpp"
+#include "../../common/grid_io.hpp"
+
+// Run description for the 2D solvers: the condition on each edge and the
+// heat source. It is read once (usually from the --config file) and turned
+// into a list of edge kernels, one instantiation per (kind, side), that the
+// solvers call after every sweep. Dirichlet edges need no kernel, so the
+// default scenario costs nothing and reproduces the original results.
+//
+//   [boundary]                      # edge = kind [profile]
+//   left   = dirichlet              # corners (the original 10/20/30/20 edges)
+//   right  = dirichlet linear 20 30 # constant v | linear a b | sine a
+//   top    = neumann constant 0     # ghost = inner + g, g from the profile
+//   bottom = periodic               # needs the opposite edge periodic too
+//   [source]                        # f in 4u - sum(neighbours) = f
+//   type = gaussian                 # none | constant | gaussian | file
+//   value = 0.5                     # constant value / gaussian peak
+//   x = 0.5                         # gaussian centre and width in [0, 1]
+//   y = 0.5
+//   sigma = 0.05
+//   file = heat.grid                # grid_io file with nx columns, ny rows
+//
+// The boundary row/column of a Neumann or periodic edge acts as a ghost
+// layer: it is rewritten from the interior after each sweep.
+namespace opt = boost::program_options;
+
+class Scenario {
+public:
+    enum class Kind { Dirichlet, Neumann, Periodic };
+    enum Side { Left, Right, Top, Bottom };
+
+    struct Edge {
+        Kind kind = Kind::Dirichlet;
+        std::string profile = "corners";
+        double a = 0.0, b = 0.0;
+    };
+
+    template <class T>
+    class Kernels {
+    private:
+        using Fn = void (*)(T*, int, int, const T*);
+        struct Entry {
+            Fn fn;
+            std::vector<T> values;   // per-cell flux of a Neumann edge
+        };
+        std::vector<Entry> list;
+    public:
+        void add(Fn fn, std::vector<T> values = {}) {
+            list.push_back({fn, std::move(values)});
+        }
+        bool empty() const {
+            return list.empty();
+        }
+        // Refreshes the ghost edges of u (nx columns, ny rows).
+        void apply(T* u, int nx, int ny) const {
+            for (const Entry& e : list)
+                e.fn(u, nx, ny, e.values.data());
+        }
+    };
+
+private:
+    Edge edges[4];
+    std::string sourceType = "none";
+    double sourceValue = 0.0, sourceX = 0.5, sourceY = 0.5, sourceSigma = 0.05;
+    std::string sourceFile;
+
+    static bool parseEdge(const std::string& text, Edge& e, std::string& err) {
+        std::istringstream in(text);
+        std::string kind;
+        in >> kind;
+        if (kind == "dirichlet")
+            e.kind = Kind::Dirichlet;
+        else if (kind == "neumann")
+            e.kind = Kind::Neumann;
+        else if (kind == "periodic")
+            e.kind = Kind::Periodic;
+        else
+        {
+            err = "unknown edge kind '" + kind + "'";
+            return false;
+        }
+        e.profile = e.kind == Kind::Dirichlet ? "corners" : "constant";
+        in >> e.profile;
+        in >> e.a >> e.b;
+        if (e.kind == Kind::Periodic)
+            return true;
+        if (e.profile == "corners" && e.kind == Kind::Dirichlet)
+            return true;
+        if (e.profile == "constant" || e.profile == "linear" || e.profile == "sine")
+            return true;
+        err = "unknown profile '" + e.profile + "'";
+        return false;
+    }
+
+    // Profile value at s in [0, 1] along the edge.
+    static double profile(const Edge& e, double s) {
+        if (e.profile == "linear")
+            return e.a + (e.b - e.a) * s;
+        if (e.profile == "sine")
+            return e.a * std::sin(M_PI * s);
+        return e.a;
+    }
+
+    // ghost = inner + g; left/right walk the rows 1..ny-2, top/bottom whole rows
+    template <class T, int S>
+    static void neumannEdge(T* u, int nx, int ny, const T* g) {
+        if (S == Left || S == Right)
+        {
+            int x = S == Left ? 0 : nx - 1;
+            int in = S == Left ? 1 : nx - 2;
+            #pragma acc parallel loop
+            for (int y = 1; y < ny - 1; y++)
+                u[size_t(y) * nx + x] = u[size_t(y) * nx + in] + g[y];
+        }
+        else
+        {
+            size_t row = S == Top ? 0 : size_t(ny - 1) * nx;
+            size_t inner = S == Top ? size_t(nx) : size_t(ny - 2) * nx;
+            #pragma acc parallel loop
+            for (int x = 0; x < nx; x++)
+                u[row + x] = u[inner + x] + g[x];
+        }
+    }
+
+    // the interior has period nx-2 (ny-2): ghost column 0 mirrors column nx-2
+    template <class T, int S>
+    static void periodicEdge(T* u, int nx, int ny, const T*) {
+        if (S == Left || S == Right)
+        {
+            int x = S == Left ? 0 : nx - 1;
+            int from = S == Left ? nx - 2 : 1;
+            #pragma acc parallel loop
+            for (int y = 1; y < ny - 1; y++)
+                u[size_t(y) * nx + x] = u[size_t(y) * nx + from];
+        }
+        else
+        {
+            size_t row = S == Top ? 0 : size_t(ny - 1) * nx;
+            size_t from = S == Top ? size_t(ny - 2) * nx : size_t(nx);
+            #pragma acc parallel loop
+            for (int x = 0; x < nx; x++)
+                u[row + x] = u[from + x];
+        }
+    }
+
+    template <class T, int S>
+    void addEdge(Kernels<T>& k, int nx, int ny) const {
+        const Edge& e = edges[S];
+        if (e.kind == Kind::Periodic)
+            k.add(&periodicEdge<T, S>);
+        else if (e.kind == Kind::Neumann)
+        {
+            int n = S == Left || S == Right ? ny : nx;
+            std::vector<T> g(n);
+            for (int i = 0; i < n; i++)
+                g[i] = T(profile(e, double(i) / (n - 1)));
+            k.add(&neumannEdge<T, S>, std::move(g));
+        }
+    }
+
+public:
+    static void addOptions(opt::options_description& desc) {
+        desc.add_options()
+            ("boundary.left",opt::value<std::string>()->default_value("dirichlet"),"Left edge: dirichlet|neumann|periodic [profile]")
+            ("boundary.right",opt::value<std::string>()->default_value("dirichlet"),"Right edge")
+            ("boundary.top",opt::value<std::string>()->default_value("dirichlet"),"Top edge (first row)")
+            ("boundary.bottom",opt::value<std::string>()->default_value("dirichlet"),"Bottom edge (last row)")
+            ("source.type",opt::value<std::string>()->default_value("none"),"none, constant, gaussian or file")
+            ("source.value",opt::value<double>()->default_value(0.0),"Constant source / gaussian peak")
+            ("source.x",opt::value<double>()->default_value(0.5),"Gaussian centre, 0..1 across the columns")
+            ("source.y",opt::value<double>()->default_value(0.5),"Gaussian centre, 0..1 across the rows")
+            ("source.sigma",opt::value<double>()->default_value(0.05),"Gaussian width, fraction of the grid")
+            ("source.file",opt::value<std::string>()->default_value(""),"Source field as a grid_io file");
+    }
+
+    bool fromOptions(const opt::variables_map& vm, std::string& err) {
+        const char* names[4] = {"boundary.left", "boundary.right", "boundary.top", "boundary.bottom"};
+        for (int s = 0; s < 4; s++)
+            if (!parseEdge(vm[names[s]].as<std::string>(), edges[s], err))
+            {
+                err = std::string(names[s]) + ": " + err;
+                return false;
+            }
+        if ((edges[Left].kind == Kind::Periodic) != (edges[Right].kind == Kind::Periodic) ||
+            (edges[Top].kind == Kind::Periodic) != (edges[Bottom].kind == Kind::Periodic))
+        {
+            err = "periodic edges come in pairs (left/right, top/bottom)";
+            return false;
+        }
+        sourceType = vm["source.type"].as<std::string>();
+        sourceValue = vm["source.value"].as<double>();
+        sourceX = vm["source.x"].as<double>();
+        sourceY = vm["source.y"].as<double>();
+        sourceSigma = vm["source.sigma"].as<double>();
+        sourceFile = vm["source.file"].as<std::string>();
+        if (sourceType != "none" && sourceType != "constant" && sourceType != "gaussian" && sourceType != "file")
+        {
+            err = "unknown source type '" + sourceType + "'";
+            return false;
+        }
+        return true;
+    }
+
+    bool hasSource() const {
+        return sourceType != "none";
+    }
+
+    // Every edge a fixed value (multigrid's coarse levels assume that).
+    bool allDirichlet() const {
+        for (const Edge& e : edges)
+            if (e.kind != Kind::Dirichlet)
+                return false;
+        return true;
+    }
+
+    // The original problem: corner-interpolated Dirichlet edges, no source.
+    bool isDefault() const {
+        for (const Edge& e : edges)
+            if (e.kind != Kind::Dirichlet || e.profile != "corners")
+                return false;
+        return !hasSource();
+    }
+
+    // Overwrites Dirichlet edges that have their own profile; call after the
+    // corner-interpolated init. Top and bottom go last and own the corners.
+    template <class T>
+    void initBoundary(T* u, int nx, int ny) const {
+        for (int s : {Left, Right, Top, Bottom})
+        {
+            const Edge& e = edges[s];
+            if (e.kind != Kind::Dirichlet || e.profile == "corners")
+                continue;
+            if (s == Left || s == Right)
+            {
+                int x = s == Left ? 0 : nx - 1;
+                for (int y = 0; y < ny; y++)
+                    u[size_t(y) * nx + x] = T(profile(e, double(y) / (ny - 1)));
+            }
+            else
+            {
+                size_t row = s == Top ? 0 : size_t(ny - 1) * nx;
+                for (int x = 0; x < nx; x++)
+                    u[row + x] = T(profile(e, double(x) / (nx - 1)));
+            }
+        }
+    }
+
+    // Edge kernels in the order they have to run: left/right, then top/bottom
+    // (whole rows, so the corners follow the columns already updated).
+    template <class T>
+    Kernels<T> compile(int nx, int ny) const {
+        Kernels<T> k;
+        addEdge<T, Left>(k, nx, ny);
+        addEdge<T, Right>(k, nx, ny);
+        addEdge<T, Top>(k, nx, ny);
+        addEdge<T, Bottom>(k, nx, ny);
+        return k;
+    }
+
+    // The source field, or an empty array when there is none.
+    template <class T>
+    bool makeSource(grid_alloc::unique_array<T>& f, int nx, int ny, std::string& err) const {
+        if (!hasSource())
+            return true;
+        size_t len = size_t(nx) * ny;
+        f = grid_alloc::make_array<T>(len);
+        if (sourceType == "file")
+        {
+            grid_io::Grid<T> g;
+            if (!grid_io::readGrid(sourceFile, g))
+            {
+                err = "cannot read source file " + sourceFile;
+                return false;
+            }
+            if (g.cols != uint64_t(nx) || g.rows != uint64_t(ny))
+            {
+                err = "source file is " + std::to_string(g.cols) + "x" + std::to_string(g.rows);
+                return false;
+            }
+            std::copy(g.data.begin(), g.data.end(), f.get());
+            return true;
+        }
+        double v = sourceValue, cx = sourceX, cy = sourceY, s2 = 2.0 * sourceSigma * sourceSigma;
+        bool gauss = sourceType == "gaussian";
+        grid_alloc::firstTouch<T>(len, [&](size_t b, size_t e) {
+            for (size_t k = b; k < e; k++)
+            {
+                if (!gauss)
+                {
+                    f[k] = T(v);
+                    continue;
+                }
+                double dx = double(k % nx) / (nx - 1) - cx;
+                double dy = double(k / nx) / (ny - 1) - cy;
+                f[k] = T(v * std::exp(-(dx * dx + dy * dy) / s2));
+            }
+        });
+        return true;
+    }
+};
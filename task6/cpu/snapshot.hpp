@@ -0,0 +1,187 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <limits>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <cstdio>
+#include "../../common/grid_io.hpp"
+#include "../../common/grid_alloc.hpp"
+
+// Periodic grid snapshots written by a background thread. The compute thread
+// only copies (and down-samples) the field into one of queueLen+1 preallocated
+// buffers and hands it over; disk I/O happens on the writer thread. When all
+// buffers are busy the policy decides: drop the new snapshot, drop the oldest
+// one still queued, or block until the writer frees a buffer.
+class SnapshotWriter {
+public:
+    enum class Policy { DropNewest, DropOldest, Block };
+
+    struct Stats {
+        long captured = 0;
+        long written = 0;
+        long dropped = 0;
+        double captureSeconds = 0.0;   // spent on the compute thread
+        double writeSeconds = 0.0;     // spent on the writer thread
+    };
+
+private:
+    struct Buffer {
+        int iter = 0;
+        grid_alloc::vector<double> data;
+    };
+    int N;
+    int every;
+    int stride;
+    int outN;
+    Policy policy;
+    std::string prefix;
+    grid_io::WriteOptions wopt;
+    std::vector<Buffer> buffers;
+    std::vector<int> freeList;
+    std::deque<int> queue;
+    std::mutex mut;
+    std::condition_variable cv;
+    bool stopping = false;
+    Stats stats;
+    std::thread writer;
+
+    void writerThread() {
+        char name[64];
+        while (true)
+        {
+            int b;
+            {
+                std::unique_lock<std::mutex> lock(mut);
+                cv.wait(lock, [this]() { return !queue.empty() || stopping; });
+                if (queue.empty())
+                    break;
+                b = queue.front();
+                queue.pop_front();
+            }
+            auto t = std::chrono::steady_clock::now();
+            std::snprintf(name, sizeof(name), "_%08d.grid", buffers[b].iter);
+            grid_io::writeGrid(prefix + name, buffers[b].data.data(), outN, outN, 1, wopt);
+            std::chrono::duration<double> d = std::chrono::steady_clock::now() - t;
+            {
+                std::unique_lock<std::mutex> lock(mut);
+                stats.written++;
+                stats.writeSeconds += d.count();
+                freeList.push_back(b);
+            }
+            cv.notify_all();
+        }
+    }
+
+    // Takes a buffer for the next snapshot, or -1 if the snapshot is dropped.
+    int acquire() {
+        std::unique_lock<std::mutex> lock(mut);
+        if (freeList.empty())
+        {
+            if (policy == Policy::DropNewest)
+            {
+                stats.dropped++;
+                return -1;
+            }
+            if (policy == Policy::DropOldest && !queue.empty())
+            {
+                int b = queue.front();
+                queue.pop_front();
+                stats.dropped++;
+                return b;
+            }
+            cv.wait(lock, [this]() { return !freeList.empty(); });
+        }
+        int b = freeList.back();
+        freeList.pop_back();
+        return b;
+    }
+
+public:
+    SnapshotWriter(int N, int every, int stride, int queueLen, Policy policy, const std::string& prefix, int compress = 0)
+        : N(N), every(every), stride(std::max(stride, 1)), policy(policy), prefix(prefix) {
+        outN = (N - 1 + this->stride - 1) / this->stride + 1;
+        wopt.compress = compress;
+        buffers.resize(std::max(queueLen, 1) + 1);
+        for (size_t b = 0; b < buffers.size(); b++)
+        {
+            buffers[b].data.resize(size_t(outN) * outN);
+            freeList.push_back(b);
+        }
+        writer = std::thread(&SnapshotWriter::writerThread, this);
+    }
+
+    ~SnapshotWriter() {
+        {
+            std::unique_lock<std::mutex> lock(mut);
+            stopping = true;
+        }
+        cv.notify_all();
+        writer.join();
+    }
+
+    static bool parsePolicy(const std::string& name, Policy& policy) {
+        if (name == "drop-newest")
+            policy = Policy::DropNewest;
+        else if (name == "drop-oldest")
+            policy = Policy::DropOldest;
+        else if (name == "block")
+            policy = Policy::Block;
+        else
+            return false;
+        return true;
+    }
+
+    bool due(int iter) const {
+        return every > 0 && iter % every == 0;
+    }
+
+    // First snapshot iteration after iter, so batched loops can stop on it.
+    int next(int iter) const {
+        return every > 0 ? (iter / every + 1) * every : std::numeric_limits<int>::max();
+    }
+
+    // Called from the compute loop with the current field (float fields are widened).
+    template <class T>
+    void capture(const T* grid, int iter) {
+        auto t = std::chrono::steady_clock::now();
+        int b = acquire();
+        if (b >= 0)
+        {
+            double* dst = buffers[b].data.data();
+            int n = outN;
+            int s = stride;
+            int last = N - 1;
+            #pragma acc parallel loop independent collapse(2)
+            for (size_t i = 0; i < n; i++)
+            {
+                for (size_t j = 0; j < n; j++)
+                {
+                    size_t si = std::min<size_t>(i * s, last);
+                    size_t sj = std::min<size_t>(j * s, last);
+                    dst[i*n+j] = grid[si*N+sj];
+                }
+            }
+            buffers[b].iter = iter;
+            {
+                std::unique_lock<std::mutex> lock(mut);
+                queue.push_back(b);
+            }
+            cv.notify_all();
+        }
+        std::chrono::duration<double> d = std::chrono::steady_clock::now() - t;
+        std::unique_lock<std::mutex> lock(mut);
+        stats.captured += b >= 0;
+        stats.captureSeconds += d.count();
+    }
+
+    // Waits until every queued snapshot is on disk.
+    Stats flush() {
+        std::unique_lock<std::mutex> lock(mut);
+        cv.wait(lock, [this]() { return queue.empty() && freeList.size() == buffers.size(); });
+        return stats;
+    }
+};
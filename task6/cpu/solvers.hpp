@@ -0,0 +1,252 @@
+#pragma once
+#include <cmath>
+#include <vector>
+#include <algorithm>
+#include <type_traits>
+#include "../../common/grid_alloc.hpp"
+#include "stencil.hpp"
+#include "../../common/vecops.hpp"
+
+// Alternative solvers for the same Laplace problem as the Jacobi sweep in
+// task.cpp. The grid is N x N row-major, the outer ring holds the Dirichlet
+// boundary and is never written. T is the storage type, Acc the type the
+// updates and max-change reductions are computed in.
+
+// Jacobi update of rows [rowBegin, rowEnd) without any parallel construct,
+// for callers that split the rows themselves (the task-graph path).
+template <bool WithError, class T, class Acc = T>
+Acc sweepRows(T* cur, const T* prev, int N, size_t rowBegin, size_t rowEnd) {
+    Acc error = 0;
+    for (size_t i = rowBegin; i < rowEnd; i++)
+    {
+        for (size_t j = 1; j < N-1; j++)
+        {
+            Acc v = Acc(0.25) * (Acc(prev[i*N+j+1]) + Acc(prev[i*N+j-1]) + Acc(prev[(i-1)*N+j]) + Acc(prev[(i+1)*N+j]));
+            if constexpr (WithError)
+                error = stencil::maxChange(error, std::fabs(v - Acc(prev[i*N+j])));
+            cur[i*N+j] = T(v);
+        }
+    }
+    return error;
+}
+
+// Over-relaxation factor that is optimal for the 5-point Laplacian on a square grid.
+inline double optimalOmega(int N) {
+    return 2.0 / (1.0 + std::sin(M_PI / (N - 1)));
+}
+
+// Updates one colour ((i+j)%2 == color) in place:
+// u += omega * (0.25*(neighbours + f) - u). f may be nullptr (no right-hand side).
+// gangs is the OpenACC gang count (task.cpp takes it from the machine profile).
+template <bool WithError, class T, class Acc = T>
+Acc sorColor(T* u, const T* f, int N, Acc omega, int color, [[maybe_unused]] int gangs = 40) {
+    Acc error = 0;
+    #pragma acc parallel loop independent gang num_gangs(gangs) reduction(max:error)
+    for (size_t i = 1; i < N-1; i++)
+    {
+        #pragma acc loop vector reduction(max:error)
+        for (size_t j = 1 + (i + color) % 2; j < N-1; j += 2)
+        {
+            Acc gs = Acc(u[i*N+j+1]) + Acc(u[i*N+j-1]) + Acc(u[(i-1)*N+j]) + Acc(u[(i+1)*N+j]);
+            if (f)
+                gs += f[i*N+j];
+            Acc d = omega * (Acc(0.25) * gs - Acc(u[i*N+j]));
+            u[i*N+j] = T(u[i*N+j] + d);
+            if constexpr (WithError)
+                error = stencil::maxChange(error, std::fabs(d));
+        }
+    }
+    return error;
+}
+
+// sorColor on rows [rowBegin, rowEnd) without any parallel construct, for
+// callers that split the rows themselves (the ensemble driver).
+template <bool WithError, class T, class Acc = T>
+Acc sorRows(T* u, const T* f, int N, Acc omega, int color, size_t rowBegin, size_t rowEnd) {
+    Acc error = 0;
+    for (size_t i = rowBegin; i < rowEnd; i++)
+    {
+        for (size_t j = 1 + (i + color) % 2; j < N-1; j += 2)
+        {
+            Acc gs = Acc(u[i*N+j+1]) + Acc(u[i*N+j-1]) + Acc(u[(i-1)*N+j]) + Acc(u[(i+1)*N+j]);
+            if (f)
+                gs += f[i*N+j];
+            Acc d = omega * (Acc(0.25) * gs - Acc(u[i*N+j]));
+            u[i*N+j] = T(u[i*N+j] + d);
+            if constexpr (WithError)
+                error = stencil::maxChange(error, std::fabs(d));
+        }
+    }
+    return error;
+}
+
+// One red-black SOR sweep, returns max|change| when computeError is set.
+template <class T, class Acc = T>
+Acc sorSweep(T* u, const T* f, int N, Acc omega, bool computeError, int gangs = 40) {
+    if (computeError)
+    {
+        // colour 0 strictly before colour 1: as two arguments of one call the
+        // order would be unspecified (g++ runs the second first)
+        Acc red = sorColor<true, T, Acc>(u, f, N, omega, 0, gangs);
+        Acc black = sorColor<true, T, Acc>(u, f, N, omega, 1, gangs);
+        return stencil::maxChange(red, black);
+    }
+    sorColor<false, T, Acc>(u, f, N, omega, 0, gangs);
+    sorColor<false, T, Acc>(u, f, N, omega, 1, gangs);
+    return 0;
+}
+
+// max|0.25*(neighbours + f) - u|, i.e. the change one Jacobi sweep would make.
+// Used to compare solvers on the same footing.
+template <class T>
+double jacobiResidual(const T* u, const T* f, int N) {
+    double res = 0.0;
+    #pragma acc parallel loop independent collapse(2) reduction(max:res)
+    for (size_t i = 1; i < N-1; i++)
+    {
+        for (size_t j = 1; j < N-1; j++)
+        {
+            double s = double(u[i*N+j+1]) + u[i*N+j-1] + u[(i-1)*N+j] + u[(i+1)*N+j];
+            if (f)
+                s += f[i*N+j];
+            res = stencil::maxChange(res, fabs(0.25 * s - u[i*N+j]));
+        }
+    }
+    return res;
+}
+
+// Geometric multigrid V-cycle with red-black Gauss-Seidel smoothing.
+// Works on the unscaled operator 4u - sum(neighbours) = f, so the coarse
+// right-hand side is the restricted residual times (H/h)^2. Coarse sizes are
+// (n+1)/2; when n-1 is odd the grids are not nested and the transfers sample
+// the other grid bilinearly at the matching physical coordinate, which
+// degrades to full weighting / bilinear prolongation for 2^k+1 sizes.
+template <class T, class Acc = T>
+class Multigrid {
+private:
+    struct Level {
+        int n;
+        grid_alloc::vector<T> u, f, r;
+    };
+    std::vector<Level> levels;
+    grid_alloc::vector<T> prev;
+    int preSmooth;
+    int postSmooth;
+
+    static Acc sample(const T* a, int n, Acc x, Acc y) {
+        x = std::clamp(x, Acc(0), Acc(n - 1));
+        y = std::clamp(y, Acc(0), Acc(n - 1));
+        int i = std::min(int(y), n - 2);
+        int j = std::min(int(x), n - 2);
+        Acc ty = y - i;
+        Acc tx = x - j;
+        return (1 - ty) * ((1 - tx) * a[i*n+j] + tx * a[i*n+j+1]) +
+               ty * ((1 - tx) * a[(i+1)*n+j] + tx * a[(i+1)*n+j+1]);
+    }
+
+    static void residual(const T* u, const T* f, T* r, int n) {
+        #pragma acc parallel loop independent collapse(2)
+        for (size_t i = 1; i < n-1; i++)
+        {
+            for (size_t j = 1; j < n-1; j++)
+            {
+                Acc fij = f ? Acc(f[i*n+j]) : Acc(0);
+                r[i*n+j] = T(fij - (Acc(4) * u[i*n+j] - u[i*n+j+1] - u[i*n+j-1] - u[(i-1)*n+j] - u[(i+1)*n+j]));
+            }
+        }
+    }
+
+    static void restrictTo(const T* r, int n, T* f, int nc) {
+        Acc s = Acc(n - 1) / (nc - 1);
+        const Acc w[3] = {0.25, 0.5, 0.25};
+        #pragma acc parallel loop independent collapse(2)
+        for (size_t I = 1; I < nc-1; I++)
+        {
+            for (size_t J = 1; J < nc-1; J++)
+            {
+                Acc acc = 0;
+                for (int a = -1; a <= 1; a++)
+                    for (int b = -1; b <= 1; b++)
+                        acc += w[a+1] * w[b+1] * sample(r, n, J * s + b, I * s + a);
+                f[I*nc+J] = T(acc * s * s);
+            }
+        }
+    }
+
+    static void prolongAdd(const T* e, int nc, T* u, int n) {
+        Acc s = Acc(nc - 1) / (n - 1);
+        #pragma acc parallel loop independent collapse(2)
+        for (size_t i = 1; i < n-1; i++)
+        {
+            for (size_t j = 1; j < n-1; j++)
+            {
+                u[i*n+j] = T(u[i*n+j] + sample(e, nc, j * s, i * s));
+            }
+        }
+    }
+
+    void vcycle(size_t l, T* u, const T* f) {
+        int n = levels[l].n;
+        if (l + 1 == levels.size())
+        {
+            for (int k = 0; k < 4 * n; k++)
+                sorSweep<T, Acc>(u, f, n, Acc(1), false);
+            return;
+        }
+        for (int k = 0; k < preSmooth; k++)
+            sorSweep<T, Acc>(u, f, n, Acc(1), false);
+        residual(u, f, levels[l].r.data(), n);
+        Level& c = levels[l + 1];
+        restrictTo(levels[l].r.data(), n, c.f.data(), c.n);
+        std::fill(c.u.begin(), c.u.end(), T(0));
+        vcycle(l + 1, c.u.data(), c.f.data());
+        prolongAdd(c.u.data(), c.n, u, n);
+        for (int k = 0; k < postSmooth; k++)
+            sorSweep<T, Acc>(u, f, n, Acc(1), false);
+    }
+
+public:
+    Multigrid(int N, int preSmooth = 2, int postSmooth = 2)
+        : preSmooth(preSmooth), postSmooth(postSmooth) {
+        int n = N;
+        levels.push_back({n, {}, {}, grid_alloc::vector<T>(size_t(n) * n, T(0))});
+        while (n > 5)
+        {
+            n = (n + 1) / 2;
+            size_t len = size_t(n) * n;
+            levels.push_back({n, grid_alloc::vector<T>(len, T(0)), grid_alloc::vector<T>(len, T(0)), grid_alloc::vector<T>(len, T(0))});
+        }
+    }
+
+    int depth() const {
+        return levels.size();
+    }
+
+    // One V-cycle on the fine grid u (f = nullptr for the Laplace problem).
+    // With computeError returns max|change| over the cycle; that needs a copy of u.
+    Acc cycle(T* u, const T* f, bool computeError) {
+        int N = levels[0].n;
+        if (computeError)
+        {
+            prev.resize(size_t(N) * N);
+            std::copy(u, u + size_t(N) * N, prev.begin());
+        }
+        vcycle(0, u, f);
+        if (!computeError)
+            return 0;
+        // the cycle has no sweep to fuse the check into, so it is the separate
+        // pass of vecops; the boundary is never written and adds nothing
+        if constexpr (std::is_same<T, Acc>::value)
+            return vecops::max_abs_diff(size_t(N) * N, u, prev.data());
+        Acc error = 0;
+        #pragma acc parallel loop independent collapse(2) reduction(max:error)
+        for (size_t i = 1; i < N-1; i++)
+        {
+            for (size_t j = 1; j < N-1; j++)
+            {
+                error = stencil::maxChange(error, std::fabs(Acc(u[i*N+j]) - Acc(prev[i*N+j])));
+            }
+        }
+        return error;
+    }
+};
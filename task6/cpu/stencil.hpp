@@ -0,0 +1,232 @@
+#pragma once
+#include <cmath>
+#include <cstddef>
+#include <algorithm>
+#include <limits>
+#include "../../common/grid_alloc.hpp"
+
+// Stencil engine for the Jacobi sweeps. A stencil is a list of integer taps
+// over a common denominator, the grid extents may be fixed at compile time,
+// so every (stencil, extents) pair gets its own inner loop with the tap
+// offsets and weights folded into constants.
+//
+// Layout is x fastest: index = (z * ny + y) * nx + x, 2D grids have nz = 1.
+// The outermost layer of cells is the Dirichlet boundary and is never written.
+// Cells closer to the boundary than a stencil's radius use its Fallback
+// (the radius-1 stencil of the same dimension).
+namespace stencil {
+
+constexpr int Dynamic = 0;
+
+// max(m, d) for the max|change| reductions. A NaN d turns into +inf:
+// std::fmax would drop it and a diverged run would stop as converged, and inf
+// also survives the max combiner of an OpenMP or OpenACC reduction.
+template <class Acc>
+inline Acc maxChange(Acc m, Acc d) {
+    return d == d ? std::fmax(m, d) : std::numeric_limits<Acc>::infinity();
+}
+
+template <int NX = Dynamic, int NY = Dynamic, int NZ = Dynamic>
+class Extents {
+private:
+    int dnx = NX;
+    int dny = NY;
+    int dnz = NZ ? NZ : 1;
+public:
+    Extents() = default;
+    Extents(int nx, int ny, int nz = 1) : dnx(NX ? NX : nx), dny(NY ? NY : ny), dnz(NZ ? NZ : nz) {}
+
+    int nx() const {
+        if constexpr (NX != Dynamic) return NX; else return dnx;
+    }
+    int ny() const {
+        if constexpr (NY != Dynamic) return NY; else return dny;
+    }
+    int nz() const {
+        if constexpr (NZ != Dynamic) return NZ; else return dnz;
+    }
+    ptrdiff_t strideY() const {
+        return nx();
+    }
+    ptrdiff_t strideZ() const {
+        return ptrdiff_t(nx()) * ny();
+    }
+    size_t size() const {
+        return size_t(nx()) * ny() * nz();
+    }
+    // interior points one sweep updates
+    double interior() const {
+        return double(nx() - 2) * (ny() - 2) * std::max(nz() - 2, 1);
+    }
+};
+
+template <int Dx, int Dy, int Dz, int W>
+struct Tap {
+    static constexpr int dx = Dx, dy = Dy, dz = Dz, w = W;
+    static constexpr int radius = std::max({Dx < 0 ? -Dx : Dx, Dy < 0 ? -Dy : Dy, Dz < 0 ? -Dz : Dz});
+};
+
+template <class Acc, class Tp, class T>
+inline Acc term(const T* p, ptrdiff_t sy, ptrdiff_t sz) {
+    Acc v = Acc(p[Tp::dx + Tp::dy * sy + Tp::dz * sz]);
+    if constexpr (Tp::w == 1)
+        return v;
+    else
+        return Acc(Tp::w) * v;
+}
+
+// new value = (sum of w * neighbour + Src * f) / Den, relaxed by omega
+// (weighted Jacobi). f is the right-hand side of the 5-point form
+// 4u - sum(neighbours) = f; Src rescales it to the stencil's own operator.
+template <int Dim, int Den, int Src, class... Taps>
+struct Stencil {
+    static constexpr int dim = Dim;
+    static constexpr double omega = 1.0;
+    static constexpr int radius = std::max({Taps::radius...});
+    static constexpr int points = sizeof...(Taps) + 1;
+
+    template <bool HasSource, class Acc, class T>
+    static Acc apply(const T* p, const T* f, ptrdiff_t sy, ptrdiff_t sz) {
+        Acc s = (... + term<Acc, Taps>(p, sy, sz));
+        if constexpr (HasSource)
+            s += Src == 1 ? Acc(*f) : Acc(Src) * Acc(*f);
+        return Acc(1.0 / Den) * s;
+    }
+};
+
+// The task6 operator, taps in the order of the original sweep so the results are bit-identical.
+struct Point5 : Stencil<2, 4, 1, Tap<1, 0, 0, 1>, Tap<-1, 0, 0, 1>, Tap<0, -1, 0, 1>, Tap<0, 1, 0, 1>> {
+    using Fallback = Point5;
+};
+
+// Compact fourth-order ("Mehrstellen") Laplacian: 4 * edge neighbours + diagonals, over 20.
+struct Box9 : Stencil<2, 20, 6, Tap<1, 0, 0, 4>, Tap<-1, 0, 0, 4>, Tap<0, -1, 0, 4>, Tap<0, 1, 0, 4>,
+                                Tap<1, 1, 0, 1>, Tap<-1, 1, 0, 1>, Tap<1, -1, 0, 1>, Tap<-1, -1, 0, 1>> {
+    using Fallback = Box9;
+};
+
+struct Point7 : Stencil<3, 6, 1, Tap<1, 0, 0, 1>, Tap<-1, 0, 0, 1>, Tap<0, -1, 0, 1>, Tap<0, 1, 0, 1>,
+                                 Tap<0, 0, -1, 1>, Tap<0, 0, 1, 1>> {
+    using Fallback = Point7;
+};
+
+// Fourth-order radius-2 star: (16 * first neighbours - second neighbours) / 90.
+// Plain Jacobi amplifies the checkerboard mode by 34/30 with it, so it runs
+// damped; omega = 0.9 brings that factor down to 0.92.
+struct Star13 : Stencil<3, 90, 12, Tap<1, 0, 0, 16>, Tap<-1, 0, 0, 16>, Tap<0, -1, 0, 16>, Tap<0, 1, 0, 16>,
+                                   Tap<0, 0, -1, 16>, Tap<0, 0, 1, 16>,
+                                   Tap<2, 0, 0, -1>, Tap<-2, 0, 0, -1>, Tap<0, -2, 0, -1>, Tap<0, 2, 0, -1>,
+                                   Tap<0, 0, -2, -1>, Tap<0, 0, 2, -1>> {
+    static constexpr double omega = 0.9;
+    using Fallback = Point7;
+};
+
+// Applies S to cells [xb, xe) of one row starting at index `row`.
+template <class S, bool WithError, bool Write, bool HasSource, class T, class Acc>
+inline Acc updateRange(T* cur, const T* prev, const T* f, size_t row, int xb, int xe, ptrdiff_t sy, ptrdiff_t sz) {
+    Acc error = 0;
+    for (int x = xb; x < xe; x++)
+    {
+        size_t k = row + x;
+        Acc v = S::template apply<HasSource, Acc>(prev + k, f + k, sy, sz);
+        if constexpr (S::omega != 1.0)
+            v = Acc(1.0 - S::omega) * Acc(prev[k]) + Acc(S::omega) * v;
+        if constexpr (WithError)
+            error = maxChange(error, std::fabs(v - Acc(prev[k])));
+        if constexpr (Write)
+            cur[k] = T(v);
+    }
+    return error;
+}
+
+// gangs and vectorLength go to the OpenACC loop over the rows; 40 and 80 are
+// the values the original task6 sweep had written into its pragmas.
+template <class S, bool WithError, bool Write, bool HasSource, class T, class Acc, class E>
+Acc apply(T* cur, const T* prev, const T* f, const E& e, [[maybe_unused]] int gangs = 40,
+          [[maybe_unused]] int vectorLength = 80) {
+    using F = typename S::Fallback;
+    constexpr int r = S::radius;
+    const int nx = e.nx(), ny = e.ny();
+    const int nz = S::dim == 3 ? e.nz() : 1;
+    const int zb = S::dim == 3 ? 1 : 0;
+    const int ze = S::dim == 3 ? nz - 1 : 1;
+    const ptrdiff_t sy = e.strideY(), sz = e.strideZ();
+    Acc error = 0;
+    #pragma acc parallel loop independent collapse(2) gang num_gangs(gangs) vector vector_length(vectorLength) reduction(max:error)
+    for (int z = zb; z < ze; z++)
+    {
+        for (int y = 1; y < ny - 1; y++)
+        {
+            size_t row = (size_t(z) * ny + y) * nx;
+            bool rim = r > 1 && (y < r || y >= ny - r || (S::dim == 3 && (z < r || z >= nz - r)));
+            int lo = rim ? nx - 1 : std::min(r, nx - 1);
+            int hi = rim ? nx - 1 : std::max(lo, nx - r);
+            Acc m = updateRange<F, WithError, Write, HasSource, T, Acc>(cur, prev, f, row, 1, lo, sy, sz);
+            m = maxChange(m, updateRange<S, WithError, Write, HasSource, T, Acc>(cur, prev, f, row, lo, hi, sy, sz));
+            m = maxChange(m, updateRange<F, WithError, Write, HasSource, T, Acc>(cur, prev, f, row, hi, nx - 1, sy, sz));
+            error = maxChange(error, m);
+        }
+    }
+    return error;
+}
+
+// One Jacobi sweep prev -> cur; with computeError returns max|cur - prev| from
+// the same pass. f (nullptr = none) selects a separate instantiation, the
+// source-free loop does not test for it per cell.
+template <class S, class T, class Acc = T, class E>
+Acc sweep(T* cur, const T* prev, const E& e, bool computeError, const T* f = nullptr, int gangs = 40,
+          int vectorLength = 80) {
+    if (f)
+        return computeError ? apply<S, true, true, true, T, Acc>(cur, prev, f, e, gangs, vectorLength)
+                            : apply<S, false, true, true, T, Acc>(cur, prev, f, e, gangs, vectorLength);
+    return computeError ? apply<S, true, true, false, T, Acc>(cur, prev, f, e, gangs, vectorLength)
+                        : apply<S, false, true, false, T, Acc>(cur, prev, f, e, gangs, vectorLength);
+}
+
+// max|S(u) - u|, the change one sweep would make.
+template <class S, class T, class E>
+double residual(const T* u, const E& e, const T* f = nullptr) {
+    if (f)
+        return apply<S, true, false, true, const T, double>(nullptr, u, f, e);
+    return apply<S, true, false, false, const T, double>(nullptr, u, f, e);
+}
+
+// The original task6 boundary: corners 10/20/30/20 with linearly interpolated
+// edges and a zero interior. In 3D every far face adds 10 (corners 10..40)
+// and faces are interpolated the same way. One parallel pass writes every
+// cell, so it is also the first touch of a fresh grid_alloc buffer.
+struct CornerInterpolated {
+    static double value(int c, int n, bool& fixed) {
+        fixed = c == 0 || c == n - 1;
+        return c == 0 ? 0.0 : c == n - 1 ? 10.0 : (double(c) * 10.0) / (n - 1);
+    }
+
+    // threads = 0: all hardware threads
+    template <int Dim, class T, class E>
+    static void init(T* a, const E& e, int threads = 0) {
+        const size_t nx = e.nx(), ny = e.ny(), nz = Dim == 3 ? e.nz() : 1;
+        grid_alloc::firstTouch<T>(nx * ny * nz, [=](size_t b, size_t end) {
+            for (size_t k = b; k < end; k++)
+            {
+                int x = k % nx, y = (k / nx) % ny, z = k / (nx * ny);
+                bool fx, fy, fz = false;
+                double vx = value(x, nx, fx), vy = value(y, ny, fy);
+                double vz = Dim == 3 ? value(z, nz, fz) : 0.0;
+                if (!(fx || fy || fz))
+                {
+                    a[k] = T(0);
+                    continue;
+                }
+                // exact corner parts first, so 2D edges round like linearInterpolation
+                double fixedPart = 10.0, interp = 0.0;
+                (fx ? fixedPart : interp) += vx;
+                (fy ? fixedPart : interp) += vy;
+                if (Dim == 3)
+                    (fz ? fixedPart : interp) += vz;
+                a[k] = T(fixedPart + interp);
+            }
+        }, threads);
+    }
+};
+
+}
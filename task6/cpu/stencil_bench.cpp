@@ -0,0 +1,48 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <string>
+#include "stencil.hpp"
+
+// Sweep throughput of the stencil engine: every stencil on a grid with
+// run-time extents, and the radius-1 stencils again with the extents fixed
+// at compile time. usage: stencil_bench [sweeps]
+
+template <class S, class E>
+void bench(const std::string& name, const E& e, int sweeps) {
+    auto a = grid_alloc::make_array<double>(e.size());
+    auto b = grid_alloc::make_array<double>(e.size());
+    stencil::CornerInterpolated::init<S::dim>(a.get(), e);
+    stencil::CornerInterpolated::init<S::dim>(b.get(), e);
+    double* prev = a.get();
+    double* cur = b.get();
+    double error = 0.0;
+    auto start = std::chrono::steady_clock::now();
+    for (int s = 0; s < sweeps; s++)
+    {
+        error = stencil::sweep<S, double>(cur, prev, e, s == sweeps - 1);
+        std::swap(prev, cur);
+    }
+    std::chrono::duration<double> d = std::chrono::steady_clock::now() - start;
+    std::cout << std::left << std::setw(28) << name << std::right << std::setw(10) << std::fixed << std::setprecision(3)
+              << e.interior() * sweeps / d.count() / 1e9 << std::setw(12) << std::scientific << std::setprecision(3)
+              << error << std::defaultfloat << std::endl;
+}
+
+int main(int argc, char const *argv[])
+{
+    int sweeps = argc > 1 ? std::atoi(argv[1]) : 200;
+    std::cout << sweeps << " sweeps" << std::endl;
+    std::cout << std::left << std::setw(28) << "stencil / extents" << std::right << std::setw(10) << "GLUP/s"
+              << std::setw(12) << "last change" << std::endl;
+    bench<stencil::Point5>("5-point 1024x1024", stencil::Extents<>(1024, 1024), sweeps);
+    bench<stencil::Point5>("5-point 1024x1024 static", stencil::Extents<1024, 1024, 1>(), sweeps);
+    bench<stencil::Point5>("5-point 2048x512", stencil::Extents<>(2048, 512), sweeps);
+    bench<stencil::Box9>("9-point 1024x1024", stencil::Extents<>(1024, 1024), sweeps);
+    bench<stencil::Box9>("9-point 1024x1024 static", stencil::Extents<1024, 1024, 1>(), sweeps);
+    bench<stencil::Point7>("7-point 128^3", stencil::Extents<>(128, 128, 128), sweeps);
+    bench<stencil::Point7>("7-point 128^3 static", stencil::Extents<128, 128, 128>(), sweeps);
+    bench<stencil::Star13>("13-point 128^3", stencil::Extents<>(128, 128, 128), sweeps);
+    bench<stencil::Star13>("13-point 128^3 static", stencil::Extents<128, 128, 128>(), sweeps);
+    return 0;
+}
@@ -6,98 +6,269 @@
 #include <fstream>
 #include <iomanip>
 #include <chrono>
+#include <string>
+#include <vector>
+#include <type_traits>
+#include "../check_policy.hpp"
+#include "solvers.hpp"
+#include "stencil.hpp"
+#include "scenario.hpp"
+#include "snapshot.hpp"
+#include "../../common/task_graph.hpp"
+#include "../../common/grid_io.hpp"
+#include "../../common/grid_alloc.hpp"
+#include "../../common/perf_regions.hpp"
+#include "../../common/autotune.hpp"
 namespace opt = boost::program_options;
 
 double linearInterpolation(double x, double x1, double y1, double x2, double y2) {
     return y1 + ((x - x1) * (y2 - y1) / (x2 - x1));
 }
-void saveMatrixToFile(const std::unique_ptr<double[]>& matrix, int N, const std::string& filename) {
+template <class T>
+void saveMatrixToFile(const grid_alloc::unique_array<T>& matrix, int cols, int rows, const std::string& filename) {
     std::ofstream outputFile(filename);
     if (!outputFile.is_open()) {
         std::cerr << "Unable to open file " << filename << " for writing." << std::endl;
         return;
     }
     int fieldWidth = 10; 
-    for (int i = 0; i < N; ++i) {
-        for (int j = 0; j < N; ++j) {
-            outputFile << std::setw(fieldWidth) << std::fixed << std::setprecision(4) << matrix[i * N + j];
+    for (int i = 0; i < rows; ++i) {
+        for (int j = 0; j < cols; ++j) {
+            outputFile << std::setw(fieldWidth) << std::fixed << std::setprecision(4) << matrix[size_t(i) * cols + j];
         }
         outputFile << std::endl;
     }
     outputFile.close();
 }
-void initMatrix(std::unique_ptr<double[]> &arr ,int N){
-        
-    arr[0] = 10.0;
-    arr[N-1] = 20.0;
-    arr[(N-1)*N + (N-1)] = 30.0;
-    arr[(N-1)*N] = 20.0;
-    for (size_t i = 1; i < N-1; i++)
-    {
-        arr[0*N+i] = linearInterpolation(i,0.0,arr[0],N-1,arr[N-1]);
-        arr[i*N+0] = linearInterpolation(i,0.0,arr[0],N-1,arr[(N-1)*N]);
-        arr[i*N+(N-1)] = linearInterpolation(i,0.0,arr[N-1],N-1,arr[(N-1)*N + (N-1)]);
-        arr[(N-1)*N+i] = linearInterpolation(i,0.0,arr[(N-1)*N],N-1,arr[(N-1)*N + (N-1)]);
-    }
+template <class T>
+void initMatrix(grid_alloc::unique_array<T> &arr ,int N){
+    stencil::CornerInterpolated::init<2>(arr.get(), stencil::Extents<>(N, N));
 }
 
-int main(int argc, char const *argv[])
-{
-    opt::options_description desc("Argument");
-    desc.add_options()
-        ("accuracy",opt::value<double>()->default_value(1e-6),"Accuracy")
-        ("cellsCount",opt::value<int>()->default_value(256),"Matrix size")
-        ("iterCount",opt::value<int>()->default_value(50),"Count of itteration")
-        ("help","help");
-    opt::variables_map vm;
-    opt::store(opt::parse_command_line(argc, argv, desc), vm);
-    opt::notify(vm);
-    if (vm.count("help")) {
-        std::cout << desc << "\n";
-        return 1;
+// One Jacobi sweep prev -> cur. With computeError the max|cur-prev| reduction
+// is done in the same pass, so checking convergence costs no extra grid read.
+// T is the storage type; the new value and the reduction are computed in Acc,
+// so float storage with double Acc reads and writes half the bytes while the
+// error is measured before rounding to float.
+// With PERF_REGIONS set it is timed as "jacobi sweep": 4 flops a point (6
+// with the reduction), prev read and cur written once. The OpenACC kernel
+// may run on other threads or the GPU, so the scope is Span::Team.
+template <class T, class Acc>
+Acc sweep(T* curmatrix, const T* prevmatrix, int N, bool computeError, const T* f = nullptr, int gangs = 40,
+          int vectorLength = 80){
+    static perf_regions::Region region("jacobi sweep");
+    double points = double(N-2) * (N-2);
+    perf_regions::Scope scope(region, points * (computeError ? 6 : 4), points * 2 * sizeof(T), perf_regions::Span::Team);
+    return stencil::sweep<stencil::Point5, T, Acc>(curmatrix, prevmatrix, stencil::Extents<>(N, N), computeError, f,
+                                                    gangs, vectorLength);
+}
+
+// Records `steps` Jacobi sweeps alternating between the two grids, the last
+// one with the fused max-change reduction into *error, like the 999+1
+// kernels captured into the CUDA graph in task8.
+template <class T, class Acc>
+void recordJacobi(TaskGraph& graph, T* prevmatrix, T* curmatrix, int N, int steps, double* error){
+    graph.clear();
+    for (int s = 0; s < steps; s++)
+    {
+        T* dst = s % 2 ? prevmatrix : curmatrix;
+        const T* src = s % 2 ? curmatrix : prevmatrix;
+        if (s == steps - 1)
+            graph.addReduceMax(N-2, [=](size_t b, size_t e) { return double(sweepRows<true, T, Acc>(dst, src, N, b+1, e+1)); }, error);
+        else
+            graph.addParallel(N-2, [=](size_t b, size_t e) { sweepRows<false, T, Acc>(dst, src, N, b+1, e+1); });
     }
-    int N = vm["cellsCount"].as<int>();
-    double accuracy = vm["accuracy"].as<double>();
-    int countIter = vm["iterCount"].as<int>();
+}
+
+struct SolveResult {
+    std::string solver;
+    int iter;
+    long long time_ms;
+    double error;
+    double residual;
+    double glups;   // grid-point updates per second / 1e9, sweep solvers only
+};
+
+struct RunOptions {
+    int N;
+    double accuracy;
+    int countIter;
+    int checkInterval;
+    bool adaptive;
+    double omega;
+    int gangs;          // OpenACC gangs of the SOR sweep
+    int sweepGangs;     // and of the Jacobi sweep, with its vector_length
+    int sweepVector;
+    int graphThreads;   // > 0: run Jacobi as a replayed task graph on that many threads
+    int nx, ny, nz;     // grid of the stencil engine path, nz = 1 for 2D
+    std::string stencil;
+    const Scenario* scenario;   // edges and source, see scenario.hpp
+};
+
+// Runs one solver from a freshly initialised grid. The converged field ends up
+// in Matr. f is the source field of the scenario, nullptr without one.
+template <class T, class Acc>
+SolveResult solve(const std::string& solver, grid_alloc::unique_array<T>& Matr, const RunOptions& o,
+                  const T* f = nullptr, SnapshotWriter* snapshots = nullptr){
+    int N = o.N;
+    double accuracy = o.accuracy;
+    int countIter = o.countIter;
+    // SOR and multigrid converge in far fewer iterations, check them every few steps
+    int checkInterval = solver == "jacobi" ? o.checkInterval : std::min(o.checkInterval, solver == "sor" ? 10 : 1);
+    CheckPolicy check(checkInterval, o.adaptive, accuracy);
     double error = 1.0;
     int iter = 0;
-    std::unique_ptr<double[]> Matr(new double[N*N]);
-    std::unique_ptr<double[]> Matrnew(new double[N*N]);
+    auto Matrnew = grid_alloc::make_array<T>(size_t(N) * N);
     initMatrix(Matr,N);
     initMatrix(Matrnew,N);
-    double* prevmatrix = Matrnew.get();
-    double* curmatrix = Matr.get();
+    o.scenario->initBoundary(Matr.get(), N, N);
+    o.scenario->initBoundary(Matrnew.get(), N, N);
+    Scenario::Kernels<T> edges = o.scenario->compile<T>(N, N);
+    T* prevmatrix = Matrnew.get();
+    T* curmatrix = Matr.get();
+    std::unique_ptr<Multigrid<T, Acc>> mg;
+    if (solver == "multigrid")
+        mg.reset(new Multigrid<T, Acc>(N));
+    std::unique_ptr<TaskGraph> graph;
+    if (o.graphThreads > 0 && solver == "jacobi")
+        graph.reset(new TaskGraph(o.graphThreads));
+    int recordedSteps = 0;
+    T* recordedPrev = nullptr;
+    double graphError = 0.0;
     auto start = std::chrono::high_resolution_clock::now();
-    while (iter < countIter && iter<10000000 && error > accuracy){
-            #pragma acc parallel loop independent collapse(2) vector vector_length(80) gang num_gangs(40)
-            for (size_t i = 1; i < N-1; i++)
+    // a non-finite error means the run diverged (maxChange turns NaN into inf)
+    while (iter < countIter && iter<10000000 && error > accuracy && std::isfinite(error)){
+            if (graph)
             {
-                for (size_t j = 1; j < N-1; j++)
+                // one replay runs up to the next check or snapshot; re-record only
+                // when the interval or the buffer roles change
+                int steps = std::min(check.next() - iter, std::min(countIter, 10000000) - iter);
+                if (snapshots)
+                    steps = std::min(steps, snapshots->next(iter) - iter);
+                if (steps != recordedSteps || prevmatrix != recordedPrev)
                 {
-                    curmatrix[i*N+j]  = 0.25 * (prevmatrix[i*N+j+1] + prevmatrix[i*N+j-1] + prevmatrix[(i-1)*N+j] + prevmatrix[(i+1)*N+j]);
+                    recordJacobi<T, Acc>(*graph, prevmatrix, curmatrix, N, steps, &graphError);
+                    recordedSteps = steps;
+                    recordedPrev = prevmatrix;
                 }
+                {
+                    static perf_regions::Region graphRegion("jacobi graph replay");
+                    double points = double(N-2) * (N-2) * steps;
+                    perf_regions::Scope scope(graphRegion, points * 4, points * 2 * sizeof(T), perf_regions::Span::Team);
+                    graph->replay();
+                }
+                iter += steps;
+                if (steps % 2)
+                    std::swap(prevmatrix, curmatrix);
+                error = graphError;
+                check.update(iter, error);
+                std::cout << "iteration: " << iter << ' ' << "error: " << error << std::endl;
+                if (snapshots && snapshots->due(iter))
+                    snapshots->capture(prevmatrix, iter);
+                continue;
             }
-            if ((iter+1) %100 == 0)
+            bool checkNow = check.due(iter+1);
+            Acc delta;
+            if (solver == "sor")
             {
-                error = 0.0;
-                #pragma acc parallel loop independent collapse(2) reduction(max:error) gang num_gangs(40) vector vector_length(80) 
-                for (size_t i = 1; i < N-1; i++)
-                {   
-                    for (size_t j = 1; j < N-1; j++)
-                    {
-                        error = fmax(error,fabs(curmatrix[i*N+j]-prevmatrix[i*N+j]));
-                    }
-                }
+                // 7 flops a point (9 with the reduction), u read and written once
+                static perf_regions::Region sorRegion("sor sweep");
+                double points = double(N-2) * (N-2);
+                perf_regions::Scope scope(sorRegion, points * (checkNow ? 9 : 7), points * 2 * sizeof(T), perf_regions::Span::Team);
+                delta = sorSweep<T, Acc>(prevmatrix, f, N, Acc(o.omega), checkNow, o.gangs);
+                edges.apply(prevmatrix, N, N);
+            }
+            else if (mg)
+            {
+                static perf_regions::Region mgRegion("multigrid cycle");
+                perf_regions::Scope scope(mgRegion, 0.0, 0.0, perf_regions::Span::Team);
+                delta = mg->cycle(prevmatrix, f, checkNow);
+            }
+            else
+            {
+                delta = sweep<T, Acc>(curmatrix, prevmatrix, N, checkNow, f, o.sweepGangs, o.sweepVector);
+                edges.apply(curmatrix, N, N);
+                T* temp = prevmatrix;
+                prevmatrix = curmatrix;
+                curmatrix = temp;
+            }
+            if (checkNow)
+            {
+                error = delta;
+                check.update(iter+1, error);
                 std::cout << "iteration: " << iter+1 << ' ' << "error: " << error << std::endl;
             }
-            double* temp = prevmatrix;
-            prevmatrix = curmatrix;
-            curmatrix = temp;
+            if (snapshots && snapshots->due(iter+1))
+                snapshots->capture(prevmatrix, iter+1);
         iter++;
     }
     auto end = std::chrono::high_resolution_clock::now();
-    auto time_s = std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count(); 
-                std::cout<< "time: " << time_s << " error: " << error << " iterarion: " << iter <<std::endl;
+    auto time_s = std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
+    if (prevmatrix != Matr.get())
+        std::swap(Matr, Matrnew);
+    double glups = mg ? 0.0 : double(N-2) * (N-2) * iter / (std::max<long long>(time_s, 1) * 1e6);
+    return {solver, iter, time_s, error, jacobiResidual<T>(Matr.get(), f, N), glups};
+}
+
+// Runs the requested solvers with storage T / accumulation Acc, prints the
+// results and writes the final field. With compareDouble the last solver is
+// repeated in double and the difference of the final fields is reported.
+template <class T, class Acc>
+int run(const opt::variables_map& vm, const RunOptions& o, const std::vector<std::string>& solvers,
+        SnapshotWriter* snapshots, bool compareDouble){
+    int N = o.N;
+    auto Matr = grid_alloc::make_array<T>(size_t(N) * N);
+    grid_alloc::unique_array<T> f;
+    std::string err;
+    if (!o.scenario->makeSource(f, N, N, err))
+    {
+        std::cerr << err << std::endl;
+        return 1;
+    }
+    std::vector<SolveResult> results;
+    for (const auto& name : solvers)
+    {
+        SolveResult r = solve<T, Acc>(name, Matr, o, f.get(), snapshots);
+        std::cout<< "solver: " << r.solver << " time: " << r.time_ms << " error: " << r.error << " iterarion: " << r.iter << " residual: " << r.residual;
+        if (r.glups > 0.0)
+            std::cout << " GLUP/s: " << r.glups;
+        std::cout << std::endl;
+        if (!std::isfinite(r.error))
+        {
+            std::cerr << r.solver << " diverged at iteration " << r.iter << std::endl;
+            return 1;
+        }
+        results.push_back(r);
+    }
+    if (snapshots)
+    {
+        SnapshotWriter::Stats st = snapshots->flush();
+        std::cout << "snapshots: captured " << st.captured << " written " << st.written << " dropped " << st.dropped
+                  << " capture time " << st.captureSeconds * 1000 << " ms write time " << st.writeSeconds * 1000 << " ms" << std::endl;
+    }
+    if (results.size() > 1)
+    {
+        std::cout << std::setw(10) << "solver" << std::setw(12) << "iterations" << std::setw(12) << "time, ms"
+                  << std::setw(14) << "residual" << std::setw(10) << "speedup" << std::endl;
+        for (const auto& r : results)
+        {
+            std::cout << std::setw(10) << r.solver << std::setw(12) << r.iter << std::setw(12) << r.time_ms
+                      << std::setw(14) << std::scientific << std::setprecision(3) << r.residual << std::defaultfloat
+                      << std::setw(10) << std::setprecision(4) << double(results[0].time_ms) / std::max<long long>(r.time_ms, 1) << std::endl;
+        }
+    }
+    if (compareDouble && !std::is_same<T, double>::value)
+    {
+        auto ref = grid_alloc::make_array<double>(size_t(N) * N);
+        grid_alloc::unique_array<double> fd;
+        o.scenario->makeSource(fd, N, N, err);
+        SolveResult r = solve<double, double>(results.back().solver, ref, o, fd.get());
+        double diff = 0.0;
+        for (size_t k = 0; k < size_t(N) * N; k++)
+            diff = std::max(diff, std::fabs(double(Matr[k]) - ref[k]));
+        std::cout << "double reference: time: " << r.time_ms << " iterarion: " << r.iter << " GLUP/s: " << r.glups
+                  << " max |field - double field|: " << diff << std::endl;
+    }
                 if (N <=13)
                 {
                     for (size_t i = 0; i < N; i++)
@@ -109,8 +280,266 @@ int main(int argc, char const *argv[])
                         std::cout << std::endl;
                     }
                 }
-    saveMatrixToFile(std::ref(Matr), N , "Out_Matr.txt");
+    if (vm["output"].as<std::string>() == "binary")
+    {
+        grid_io::WriteOptions wopt;
+        wopt.threads = std::thread::hardware_concurrency();
+        wopt.compress = vm["compress"].as<int>();
+        grid_io::writeGrid("Out_Matr.grid", Matr.get(), N, N, 1, wopt);
+    }
+    else
+        saveMatrixToFile(Matr, N, N, "Out_Matr.txt");
     Matr = nullptr;
-    Matrnew = nullptr;  
     return 0;
+}
+
+// Jacobi with any of the stencil engine's operators on an nx x ny (x nz)
+// grid. SOR, multigrid, the task graph and snapshots stay on the square
+// 5-point path above.
+template <class S, class T, class Acc>
+SolveResult solveStencil(grid_alloc::unique_array<T>& Matr, const RunOptions& o, const T* f){
+    stencil::Extents<> ext(o.nx, o.ny, o.nz);
+    CheckPolicy check(o.checkInterval, o.adaptive, o.accuracy);
+    double error = 1.0;
+    int iter = 0;
+    auto Matrnew = grid_alloc::make_array<T>(ext.size());
+    stencil::CornerInterpolated::init<S::dim>(Matr.get(), ext);
+    stencil::CornerInterpolated::init<S::dim>(Matrnew.get(), ext);
+    o.scenario->initBoundary(Matr.get(), o.nx, o.ny);
+    o.scenario->initBoundary(Matrnew.get(), o.nx, o.ny);
+    Scenario::Kernels<T> edges = o.scenario->compile<T>(o.nx, o.ny);
+    T* prevmatrix = Matrnew.get();
+    T* curmatrix = Matr.get();
+    auto start = std::chrono::high_resolution_clock::now();
+    while (iter < o.countIter && error > o.accuracy && std::isfinite(error)){
+        bool checkNow = check.due(iter+1);
+        Acc delta = stencil::sweep<S, T, Acc>(curmatrix, prevmatrix, ext, checkNow, f, o.sweepGangs, o.sweepVector);
+        edges.apply(curmatrix, o.nx, o.ny);
+        std::swap(prevmatrix, curmatrix);
+        if (checkNow)
+        {
+            error = delta;
+            check.update(iter+1, error);
+            std::cout << "iteration: " << iter+1 << ' ' << "error: " << error << std::endl;
+        }
+        iter++;
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    auto time_s = std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
+    if (prevmatrix != Matr.get())
+        std::swap(Matr, Matrnew);
+    double glups = ext.interior() * iter / (std::max<long long>(time_s, 1) * 1e6);
+    return {"jacobi", iter, time_s, error, stencil::residual<S>(Matr.get(), ext, f), glups};
+}
+
+template <class T, class Acc>
+int runStencil(const opt::variables_map& vm, const RunOptions& o){
+    auto Matr = grid_alloc::make_array<T>(size_t(o.nx) * o.ny * o.nz);
+    grid_alloc::unique_array<T> f;
+    std::string err;
+    if (!o.scenario->makeSource(f, o.nx, o.ny, err))
+    {
+        std::cerr << err << std::endl;
+        return 1;
+    }
+    SolveResult r;
+    if (o.stencil == "5")
+        r = solveStencil<stencil::Point5, T, Acc>(Matr, o, f.get());
+    else if (o.stencil == "9")
+        r = solveStencil<stencil::Box9, T, Acc>(Matr, o, f.get());
+    else if (o.stencil == "7")
+        r = solveStencil<stencil::Point7, T, Acc>(Matr, o, f.get());
+    else
+        r = solveStencil<stencil::Star13, T, Acc>(Matr, o, f.get());
+    std::cout << "grid: " << o.nx << 'x' << o.ny;
+    if (o.nz > 1)
+        std::cout << 'x' << o.nz;
+    std::cout << " stencil: " << o.stencil << "-point time: " << r.time_ms << " error: " << r.error
+              << " iterarion: " << r.iter << " residual: " << r.residual << " GLUP/s: " << r.glups << std::endl;
+    if (!std::isfinite(r.error))
+    {
+        std::cerr << "jacobi diverged at iteration " << r.iter << std::endl;
+        return 1;
+    }
+    if (vm["output"].as<std::string>() == "binary")
+    {
+        grid_io::WriteOptions wopt;
+        wopt.threads = std::thread::hardware_concurrency();
+        wopt.compress = vm["compress"].as<int>();
+        grid_io::writeGrid("Out_Matr.grid", Matr.get(), o.ny, o.nx, o.nz, wopt);
+    }
+    else
+        saveMatrixToFile(Matr, o.nx, o.ny * o.nz, "Out_Matr.txt");   // 3D: planes one after another
+    return 0;
+}
+
+int main(int argc, char const *argv[])
+{
+    opt::options_description desc("Argument");
+    desc.add_options()
+        ("accuracy",opt::value<double>()->default_value(1e-6),"Accuracy")
+        ("cellsCount",opt::value<int>()->default_value(256),"Matrix size")
+        ("cellsY",opt::value<int>()->default_value(0),"Rows of a rectangular grid, 0 = cellsCount")
+        ("cellsZ",opt::value<int>()->default_value(1),"Planes of a 3D grid, 1 = 2D")
+        ("stencil",opt::value<std::string>()->default_value(""),"5 or 9 (2D), 7 or 13 (3D); default 5, or 7 when cellsZ > 1")
+        ("iterCount",opt::value<int>()->default_value(50),"Count of itteration")
+        ("checkInterval",opt::value<int>()->default_value(100),"Iterations between error checks")
+        ("adaptive","Choose the check interval from the observed convergence rate")
+        ("solver",opt::value<std::string>()->default_value("jacobi"),"jacobi, sor, multigrid or all (compare against jacobi)")
+        ("omega",opt::value<double>()->default_value(0.0),"SOR relaxation factor, 0 = optimal for the grid size")
+        ("precision",opt::value<std::string>()->default_value("double"),"double, float, or mixed (float grid, double arithmetic and error)")
+        ("compareDouble","Repeat the run in double and report the final field difference")
+        ("graph",opt::value<int>()->default_value(0),"Run Jacobi as a recorded task graph replayed on this many threads, 0 = off")
+        ("output",opt::value<std::string>()->default_value("text"),"text (Out_Matr.txt) or binary (Out_Matr.grid)")
+        ("compress",opt::value<int>()->default_value(0),"zlib level for binary output, 0 = raw")
+        ("snapshotEvery",opt::value<int>()->default_value(0),"Write a snapshot every K iterations, 0 = off")
+        ("snapshotStride",opt::value<int>()->default_value(1),"Keep every s-th row and column in snapshots")
+        ("snapshotQueue",opt::value<int>()->default_value(2),"Snapshots waiting for the writer thread")
+        ("snapshotPolicy",opt::value<std::string>()->default_value("drop-oldest"),"drop-newest, drop-oldest or block when the queue is full")
+        ("snapshotPrefix",opt::value<std::string>()->default_value("snap"),"Snapshot files are <prefix>_<iteration>.grid")
+        ("config",opt::value<std::string>(),"Run description file: any of these options plus [boundary] and [source], see scenario.hpp")
+        ("help","help");
+    Scenario::addOptions(desc);
+    opt::variables_map vm;
+    opt::store(opt::parse_command_line(argc, argv, desc), vm);
+    // the command line is stored first, so it wins over the file
+    if (vm.count("config"))
+        opt::store(opt::parse_config_file<char>(vm["config"].as<std::string>().c_str(), desc), vm);
+    opt::notify(vm);
+    if (vm.count("help")) {
+        std::cout << desc << "\n";
+        return 1;
+    }
+    RunOptions o;
+    int N = vm["cellsCount"].as<int>();
+    o.N = N;
+    o.accuracy = vm["accuracy"].as<double>();
+    o.countIter = vm["iterCount"].as<int>();
+    o.checkInterval = vm["checkInterval"].as<int>();
+    o.adaptive = vm.count("adaptive") > 0;
+    o.graphThreads = vm["graph"].as<int>();
+    std::string solver = vm["solver"].as<std::string>();
+    o.omega = vm["omega"].as<double>();
+    if (o.omega <= 0.0)
+        o.omega = optimalOmega(N);
+    // SOR's num_gangs and the Jacobi sweep's num_gangs / vector_length (40
+    // and 80 by hand before) for this N from the machine profile;
+    // AUTOTUNE=tune times 20 sweeps per candidate first (common/autotune.hpp).
+    // The host build has no gangs, so there is nothing to tune.
+    o.gangs = 40;
+    o.sweepGangs = 40;
+    o.sweepVector = 80;
+#ifdef _OPENACC
+    if (solver == "jacobi" || solver == "all")
+    {
+        autotune::Space space = {{"gangs", {40, 20, 80, 160, 320}}, {"vector_length", {80, 32, 64, 128, 256}}};
+        auto a = grid_alloc::make_array<double>(size_t(N) * N);
+        auto b = grid_alloc::make_array<double>(size_t(N) * N);
+        initMatrix(a, N);
+        initMatrix(b, N);
+        autotune::Config launch = autotune::select("task6/jacobi", N, space, [&](const autotune::Config& c) {
+            for (int s = 0; s < 20; s++)
+                stencil::sweep<stencil::Point5, double>(s % 2 ? a.get() : b.get(), s % 2 ? b.get() : a.get(),
+                                                        stencil::Extents<>(N, N), s == 19, nullptr,
+                                                        c.at("gangs"), c.at("vector_length"));
+        });
+        o.sweepGangs = launch.at("gangs");
+        o.sweepVector = launch.at("vector_length");
+    }
+    if (solver == "sor" || solver == "all")
+    {
+        autotune::Space space = {{"gangs", {40, 10, 20, 80, 160, 320}}};
+        auto u = grid_alloc::make_array<double>(size_t(N) * N);
+        initMatrix(u, N);
+        o.gangs = autotune::select("task6/sor", N, space, [&](const autotune::Config& c) {
+            for (int s = 0; s < 20; s++)
+                sorSweep<double, double>(u.get(), nullptr, N, o.omega, s == 19, c.at("gangs"));
+        }).at("gangs");
+    }
+#endif
+    o.nx = N;
+    o.ny = vm["cellsY"].as<int>() > 0 ? vm["cellsY"].as<int>() : N;
+    o.nz = vm["cellsZ"].as<int>();
+    o.stencil = vm["stencil"].as<std::string>();
+    if (o.stencil.empty())
+        o.stencil = o.nz > 1 ? "7" : "5";
+    bool threeD = o.stencil == "7" || o.stencil == "13";
+    if (!(o.stencil == "5" || o.stencil == "9" || threeD) || threeD != (o.nz > 1) || o.nz < 1)
+    {
+        std::cerr << "Stencil " << o.stencil << " does not fit a grid with cellsZ = " << o.nz << std::endl;
+        return 1;
+    }
+    // anything but the square 5-point grid goes through the stencil engine
+    bool general = o.stencil != "5" || o.ny != N;
+    Scenario scenario;
+    std::string err;
+    if (!scenario.fromOptions(vm, err))
+    {
+        std::cerr << err << std::endl;
+        return 1;
+    }
+    o.scenario = &scenario;
+    if (!scenario.isDefault() && (o.nz > 1 || o.graphThreads > 0))
+    {
+        std::cerr << "boundary and source settings apply to 2D grids without --graph" << std::endl;
+        return 1;
+    }
+    if (!scenario.allDirichlet() && (solver == "multigrid" || solver == "all"))
+    {
+        std::cerr << "multigrid needs Dirichlet edges" << std::endl;
+        return 1;
+    }
+
+    std::vector<std::string> solvers;
+    if (solver == "all")
+        solvers = {"jacobi", "sor", "multigrid"};
+    else if (solver == "jacobi" || solver == "sor" || solver == "multigrid")
+        solvers = {solver};
+    else {
+        std::cerr << "Unknown solver " << solver << std::endl;
+        return 1;
+    }
+
+    if (general)
+    {
+        if (solver != "jacobi" || o.graphThreads > 0 || vm["snapshotEvery"].as<int>() > 0)
+        {
+            std::cerr << "sor, multigrid, --graph and snapshots need a square grid with the 5-point stencil" << std::endl;
+            return 1;
+        }
+        std::string precision = vm["precision"].as<std::string>();
+        if (precision == "double")
+            return runStencil<double, double>(vm, o);
+        if (precision == "float")
+            return runStencil<float, float>(vm, o);
+        if (precision == "mixed")
+            return runStencil<float, double>(vm, o);
+        std::cerr << "Unknown precision " << precision << std::endl;
+        return 1;
+    }
+
+    std::unique_ptr<SnapshotWriter> snapshots;
+    if (vm["snapshotEvery"].as<int>() > 0)
+    {
+        SnapshotWriter::Policy policy;
+        if (!SnapshotWriter::parsePolicy(vm["snapshotPolicy"].as<std::string>(), policy))
+        {
+            std::cerr << "Unknown snapshot policy " << vm["snapshotPolicy"].as<std::string>() << std::endl;
+            return 1;
+        }
+        snapshots.reset(new SnapshotWriter(N, vm["snapshotEvery"].as<int>(), vm["snapshotStride"].as<int>(),
+                                           vm["snapshotQueue"].as<int>(), policy, vm["snapshotPrefix"].as<std::string>(),
+                                           vm["compress"].as<int>()));
+    }
+
+    std::string precision = vm["precision"].as<std::string>();
+    bool compareDouble = vm.count("compareDouble") > 0;
+    if (precision == "double")
+        return run<double, double>(vm, o, solvers, snapshots.get(), compareDouble);
+    if (precision == "float")
+        return run<float, float>(vm, o, solvers, snapshots.get(), compareDouble);
+    if (precision == "mixed")
+        return run<float, double>(vm, o, solvers, snapshots.get(), compareDouble);
+    std::cerr << "Unknown precision " << precision << std::endl;
+    return 1;
 }
\ No newline at end of file
@@ -7,6 +7,9 @@
 #include <fstream>
 #include <iomanip>
 #include <chrono>
+#include "../check_policy.hpp"
+#include "../../common/grid_io.hpp"
+#include "../../common/grid_alloc.hpp"
 namespace opt = boost::program_options;
 
 template <class ctype>
@@ -14,7 +17,7 @@ class Data {
 private:
     int len;
 public:
-    std::vector<ctype> arr;
+    grid_alloc::vector<ctype> arr;
     Data(int length) : len(length), arr(len) {
         #pragma acc enter data copyin(this)
         #pragma acc enter data create(arr[0:len])
@@ -29,7 +32,9 @@ double linearInterpolation(double x, double x1, double y1, double x2, double y2)
     return y1 + ((x - x1) * (y2 - y1) / (x2 - x1));
 }
 
-void init(std::vector<double>& arr, int size) {
+void init(grid_alloc::vector<double>& arr, int size) {
+    // the allocator does not zero the grid, the interior is first touched here in parallel
+    grid_alloc::parallelFill(arr.data(), arr.size(), 0.0);
     arr[0] = 10.0;
     arr[size-1] = 20.0;
     arr[(size-1)*size + (size-1)] = 30.0;
@@ -68,6 +73,10 @@ desc.add_options()
         ("accuracy",opt::value<double>(),"Accuracy")
         ("size",opt::value<int>(),"Size of matrix")
         ("count",opt::value<int>(),"Count of iteretions")
+        ("checkInterval",opt::value<int>()->default_value(1000),"Iterations between error checks")
+        ("adaptive","Choose the check interval from the observed convergence rate")
+        ("output",opt::value<std::string>()->default_value("text"),"text (matrix.txt) or binary (matrix.grid)")
+        ("compress",opt::value<int>()->default_value(0),"zlib level for binary output, 0 = raw")
         ("help","Help");
 
     opt::variables_map vm;
@@ -84,6 +93,7 @@ desc.add_options()
     int size = vm["size"].as<int>();
     double accuracy = vm["accuracy"].as<double>();
     int count_iter = vm["count"].as<int>();
+    CheckPolicy check(vm["checkInterval"].as<int>(), vm.count("adaptive") > 0, accuracy);
 
     double error = 1.0;
     int iter = 0;
@@ -102,27 +112,31 @@ desc.add_options()
     {
         while (iter < count_iter && error > accuracy) {
 
-            #pragma acc parallel loop collapse(2) present(matrix,last_matrix)
-
-            for (size_t i = 1; i < size-1; i++) {
-                for (size_t j = 1; j < size-1; j++) {
-
-                    matrix[i*size+j]  = 0.25 * (last_matrix[i*size+j+1] + last_matrix[i*size+j-1] + last_matrix[(i-1)*size+j] + last_matrix[(i+1)*size+j]);
-                }
-            }
-
-            if ((iter+1)%1000 == 0){
+            if (check.due(iter+1)) {
+                // the max-delta reduction rides along with the update, no second pass over the grid
                 error = 0.0;
                 #pragma acc update device(error)
                 #pragma acc parallel loop collapse(2) reduction(max:error) present(matrix,last_matrix)
 
                 for (size_t i = 1; i < size-1; i++) {
                     for (size_t j = 1; j < size-1; j++) {
-                        error = fmax(error,fabs(matrix[i*size+j]-last_matrix[i*size+j]));
+                        double v = 0.25 * (last_matrix[i*size+j+1] + last_matrix[i*size+j-1] + last_matrix[(i-1)*size+j] + last_matrix[(i+1)*size+j]);
+                        error = fmax(error,fabs(v-last_matrix[i*size+j]));
+                        matrix[i*size+j] = v;
                     }
                 }
                 #pragma acc update self(error)
+                check.update(iter+1, error);
             // std::cout << "iter № " << iter << " Error = " << error << std::endl;
+            } else {
+                #pragma acc parallel loop collapse(2) present(matrix,last_matrix)
+
+                for (size_t i = 1; i < size-1; i++) {
+                    for (size_t j = 1; j < size-1; j++) {
+
+                        matrix[i*size+j]  = 0.25 * (last_matrix[i*size+j+1] + last_matrix[i*size+j-1] + last_matrix[(i-1)*size+j] + last_matrix[(i+1)*size+j]);
+                    }
+                }
             }
 
             std::swap(last_matrix, matrix);
@@ -146,7 +160,14 @@ desc.add_options()
         }
     }
 
-    savematrix(A.arr.data(), size , "matrix.txt");
+    if (vm["output"].as<std::string>() == "binary") {
+        grid_io::WriteOptions wopt;
+        wopt.threads = std::thread::hardware_concurrency();
+        wopt.compress = vm["compress"].as<int>();
+        grid_io::writeGrid("matrix.grid", A.arr.data(), size, size, 1, wopt);
+    } else {
+        savematrix(A.arr.data(), size , "matrix.txt");
+    }
 
     return 0;
 }
@@ -0,0 +1,193 @@
+#include <iostream>
+#include <boost/program_options.hpp>
+#include <cmath>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <mpi.h>
+#include "../check_policy.hpp"
+#include "../../common/grid_io.hpp"
+namespace opt = boost::program_options;
+
+// The task6 Jacobi solver split by rows over MPI ranks. Each rank keeps its
+// rows plus one halo row above and below. Every sweep posts the halo
+// exchange, updates the rows that do not touch a halo, and only then waits
+// for the neighbours and finishes its first and last row. The max-change
+// check is reduced with MPI_Allreduce on the iterations CheckPolicy picks.
+
+double linearInterpolation(double x, double x1, double y1, double x2, double y2) {
+    return y1 + ((x - x1) * (y2 - y1) / (x2 - x1));
+}
+
+struct Slab {
+    int N;          // global grid is N x N
+    int first;      // first global row owned by this rank
+    int rows;       // rows owned by this rank
+    std::vector<double> a, b;   // (rows + 2) x N, local row 0 and rows+1 are halos
+
+    double* row(std::vector<double>& v, int local) {
+        return v.data() + size_t(local) * N;
+    }
+};
+
+// Same boundary as initMatrix: corners 10/20/30/20, edges interpolated, interior 0.
+void initSlab(std::vector<double>& arr, const Slab& s) {
+    int N = s.N;
+    std::fill(arr.begin(), arr.end(), 0.0);
+    for (int l = 1; l <= s.rows; l++)
+    {
+        int g = s.first + l - 1;
+        double* r = arr.data() + size_t(l) * N;
+        if (g == 0 || g == N-1)
+        {
+            double left = g == 0 ? 10.0 : 20.0;
+            double right = g == 0 ? 20.0 : 30.0;
+            for (int j = 0; j < N; j++)
+                r[j] = linearInterpolation(j, 0.0, left, N-1, right);
+        }
+        else
+        {
+            r[0] = linearInterpolation(g, 0.0, 10.0, N-1, 20.0);
+            r[N-1] = linearInterpolation(g, 0.0, 20.0, N-1, 30.0);
+        }
+    }
+}
+
+// Updates local rows [lb, ub], skipping the global boundary rows.
+double sweepRows(double* cur, const double* prev, const Slab& s, int lb, int ub, bool computeError) {
+    int N = s.N;
+    lb = std::max(lb, 1 - s.first + 1);
+    ub = std::min(ub, N - 2 - s.first + 1);
+    double error = 0.0;
+    #pragma omp parallel for reduction(max:error) if(ub - lb > 16)
+    for (int l = lb; l <= ub; l++)
+    {
+        for (int j = 1; j < N-1; j++)
+        {
+            size_t k = size_t(l) * N + j;
+            double v = 0.25 * (prev[k+1] + prev[k-1] + prev[k-N] + prev[k+N]);
+            if (computeError)
+                error = fmax(error, fabs(v - prev[k]));
+            cur[k] = v;
+        }
+    }
+    return error;
+}
+
+int main(int argc, char *argv[])
+{
+    MPI_Init(&argc, &argv);
+    int rank, size;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+
+    opt::options_description desc("Argument");
+    desc.add_options()
+        ("accuracy",opt::value<double>()->default_value(1e-6),"Accuracy")
+        ("cellsCount",opt::value<int>()->default_value(256),"Matrix size")
+        ("iterCount",opt::value<int>()->default_value(50),"Count of itteration")
+        ("checkInterval",opt::value<int>()->default_value(100),"Iterations between error checks")
+        ("adaptive","Choose the check interval from the observed convergence rate")
+        ("weak","cellsCount is the size for one rank, the grid grows as sqrt(ranks)")
+        ("output",opt::value<std::string>()->default_value("none"),"none or binary (Out_Matr.grid, written with MPI-IO)")
+        ("help","help");
+    opt::variables_map vm;
+    opt::store(opt::parse_command_line(argc, argv, desc), vm);
+    opt::notify(vm);
+    if (vm.count("help")) {
+        if (rank == 0)
+            std::cout << desc << "\n";
+        MPI_Finalize();
+        return 1;
+    }
+    int N = vm["cellsCount"].as<int>();
+    if (vm.count("weak"))
+        N = int(std::lround(N * std::sqrt(double(size))));
+    double accuracy = vm["accuracy"].as<double>();
+    int countIter = vm["iterCount"].as<int>();
+    CheckPolicy check(vm["checkInterval"].as<int>(), vm.count("adaptive") > 0, accuracy);
+    if (N < size + 2)
+    {
+        if (rank == 0)
+            std::cerr << "Grid of " << N << " rows is too small for " << size << " ranks" << std::endl;
+        MPI_Finalize();
+        return 1;
+    }
+
+    Slab s;
+    s.N = N;
+    s.rows = N / size + (rank < N % size);
+    s.first = rank * (N / size) + std::min(rank, N % size);
+    s.a.resize(size_t(s.rows + 2) * N);
+    s.b.resize(size_t(s.rows + 2) * N);
+    initSlab(s.a, s);
+    initSlab(s.b, s);
+    int up = rank > 0 ? rank - 1 : MPI_PROC_NULL;
+    int down = rank < size - 1 ? rank + 1 : MPI_PROC_NULL;
+
+    double* prev = s.a.data();
+    double* cur = s.b.data();
+    double error = 1.0;
+    int iter = 0;
+    double commTime = 0.0;
+    MPI_Barrier(MPI_COMM_WORLD);
+    double start = MPI_Wtime();
+    while (iter < countIter && error > accuracy)
+    {
+        MPI_Request req[4];
+        MPI_Irecv(prev, N, MPI_DOUBLE, up, 0, MPI_COMM_WORLD, &req[0]);
+        MPI_Irecv(prev + size_t(s.rows + 1) * N, N, MPI_DOUBLE, down, 1, MPI_COMM_WORLD, &req[1]);
+        MPI_Isend(prev + N, N, MPI_DOUBLE, up, 1, MPI_COMM_WORLD, &req[2]);
+        MPI_Isend(prev + size_t(s.rows) * N, N, MPI_DOUBLE, down, 0, MPI_COMM_WORLD, &req[3]);
+
+        bool checkNow = check.due(iter+1);
+        double local = sweepRows(cur, prev, s, 2, s.rows - 1, checkNow);
+        double t = MPI_Wtime();
+        MPI_Waitall(4, req, MPI_STATUSES_IGNORE);
+        commTime += MPI_Wtime() - t;
+        local = std::max(local, sweepRows(cur, prev, s, 1, 1, checkNow));
+        if (s.rows > 1)
+            local = std::max(local, sweepRows(cur, prev, s, s.rows, s.rows, checkNow));
+
+        if (checkNow)
+        {
+            t = MPI_Wtime();
+            MPI_Allreduce(&local, &error, 1, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+            commTime += MPI_Wtime() - t;
+            check.update(iter+1, error);
+            if (rank == 0)
+                std::cout << "iteration: " << iter+1 << ' ' << "error: " << error << std::endl;
+        }
+        std::swap(prev, cur);
+        iter++;
+    }
+    double elapsed = MPI_Wtime() - start;
+    double maxComm;
+    MPI_Reduce(&commTime, &maxComm, 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+    if (rank == 0)
+        std::cout << "ranks: " << size << " N: " << N << " time: " << elapsed * 1000 << " ms comm wait: "
+                  << maxComm * 1000 << " ms error: " << error << " iterarion: " << iter
+                  << " GLUP/s: " << double(N-2) * (N-2) * iter / elapsed / 1e9 << std::endl;
+
+    if (vm["output"].as<std::string>() == "binary")
+    {
+        // every rank writes its own rows after the header, no gather on rank 0
+        MPI_File fh;
+        MPI_File_open(MPI_COMM_WORLD, "Out_Matr.grid", MPI_MODE_CREATE | MPI_MODE_WRONLY, MPI_INFO_NULL, &fh);
+        MPI_File_set_size(fh, 0);
+        if (rank == 0)
+        {
+            grid_io::Header h;
+            h.rows = N;
+            h.cols = N;
+            h.payload = uint64_t(N) * N * sizeof(double);
+            MPI_File_write_at(fh, 0, &h, sizeof(h), MPI_BYTE, MPI_STATUS_IGNORE);
+        }
+        MPI_Offset off = sizeof(grid_io::Header) + MPI_Offset(s.first) * N * sizeof(double);
+        MPI_File_write_at_all(fh, off, prev + N, s.rows * N, MPI_DOUBLE, MPI_STATUS_IGNORE);
+        MPI_File_close(&fh);
+    }
+    MPI_Finalize();
+    return 0;
+}
@@ -0,0 +1,21 @@
+#!/bin/bash
+# Strong scaling: fixed grid, more ranks. Weak scaling: cellsCount per rank,
+# the grid grows with sqrt(ranks) so every rank keeps the same work.
+# usage: ./scaling.sh [N] [iterations] [max ranks]
+N=${1:-2048}
+ITERS=${2:-500}
+MAXNP=${3:-$(nproc)}
+MPIRUN="mpirun --oversubscribe"
+[ "$(id -u)" = 0 ] && MPIRUN="$MPIRUN --allow-run-as-root"
+export OMP_NUM_THREADS=1
+
+echo "strong scaling, N = $N"
+for np in 1 2 4 8 16 32; do
+    [ $np -gt $MAXNP ] && break
+    $MPIRUN -np $np ./heat_mpi --cellsCount $N --iterCount $ITERS --checkInterval 100 | tail -1
+done
+echo "weak scaling, N = $N per rank"
+for np in 1 2 4 8 16 32; do
+    [ $np -gt $MAXNP ] && break
+    $MPIRUN -np $np ./heat_mpi --cellsCount $N --iterCount $ITERS --checkInterval 100 --weak | tail -1
+done
@@ -0,0 +1,129 @@
+#include <iostream>
+#include <iomanip>
+#include <omp.h>
+#include <cmath>
+#include <boost/program_options.hpp>
+#include <vector>
+#include <chrono>
+#include "../common/vecops.hpp"
+#include "../common/grid_alloc.hpp"
+
+// The task7 solver on the host: the same Jacobi sweep and error check every
+// 1000 iterations, with vecops instead of cuBLAS so it runs without a GPU.
+// --blas reproduces tash.cpp step by step (axpy into lastMatrix, iamax,
+// copy back); the default uses the fused max_abs_diff and keeps both grids.
+
+namespace opt = boost::program_options;
+
+template <class ctype>
+class Data {
+private:
+    int len;
+public:
+    grid_alloc::vector<ctype> arr;
+    Data(int length) : len(length), arr(len) {}
+};
+
+double linearInterpolation(double x, double x1, double y1, double x2, double y2) {
+    return y1 + ((x - x1) * (y2 - y1) / (x2 - x1));
+}
+
+void init(Data<double>& matrix, int size) {
+    // arr is left uninitialised by its allocator; this is the first touch
+    grid_alloc::parallelFill(matrix.arr.data(), matrix.arr.size(), 0.0);
+    matrix.arr[0] = 10.0;
+    matrix.arr[size - 1] = 20.0;
+    matrix.arr[(size - 1) * size + (size - 1)] = 30.0;
+    matrix.arr[(size - 1) * size] = 20.0;
+    for (int i = 1; i < size - 1; ++i) {
+        matrix.arr[i * size + 0] = linearInterpolation(i, 0.0, matrix.arr[0], size - 1, matrix.arr[(size - 1) * size]);
+    }
+    for (int i = 1; i < size - 1; ++i) {
+        matrix.arr[0 * size + i] = linearInterpolation(i, 0.0, matrix.arr[0], size - 1, matrix.arr[size - 1]);
+    }
+    for (int i = 1; i < size - 1; ++i) {
+        matrix.arr[(size - 1) * size + i] = linearInterpolation(i, 0.0, matrix.arr[(size - 1) * size], size - 1, matrix.arr[(size - 1) * size + (size - 1)]);
+    }
+    for (int i = 1; i < size - 1; ++i) {
+        matrix.arr[i * size + (size - 1)] = linearInterpolation(i, 0.0, matrix.arr[size - 1], size - 1, matrix.arr[(size - 1) * size + (size - 1)]);
+    }
+}
+
+int main(int argc, char const *argv[]) {
+    opt::options_description desc("options");
+    desc.add_options()
+        ("accuracy", opt::value<double>(), "Accuracy")
+        ("size", opt::value<int>(), "Size of matrix")
+        ("count", opt::value<int>(), "Count of iterations")
+        ("blas", "Check the error with axpy + iamax + copy like the cuBLAS version")
+        ("help", "Help");
+    opt::variables_map vm;
+    opt::store(opt::parse_command_line(argc, argv, desc), vm);
+    opt::notify(vm);
+    if (vm.count("help")) {
+        std::cout << desc << "\n";
+        return 1;
+    }
+    if (!vm.count("size") || !vm.count("accuracy") || !vm.count("count")) {
+        std::cerr << "Missing required arguments: size, accuracy, or count.\n";
+        return 1;
+    }
+    auto start = std::chrono::high_resolution_clock::now();
+    int size = vm["size"].as<int>();
+    double accuracy = vm["accuracy"].as<double>();
+    int countIter = vm["count"].as<int>();
+    bool blas = vm.count("blas") > 0;
+
+    Data<double> matrix(size * size);
+    Data<double> lastMatrix(size * size);
+    init(matrix, size);
+    init(lastMatrix, size);
+    double* matrix1 = matrix.arr.data();
+    double* lastMatrix1 = lastMatrix.arr.data();
+    size_t len = size_t(size) * size;
+    double error = accuracy + 1;
+    double checkTime = 0.0;
+
+    int iter = 0;
+    const double coef = -1.0;
+    while (iter < countIter) {
+        #pragma omp parallel for schedule(static)
+        for (int i = 1; i < size - 1; i++) {
+            #pragma omp simd
+            for (int j = 1; j < size - 1; j++) {
+                matrix1[i * size + j] = 0.25 * (lastMatrix1[i * size + j + 1] +
+                                                lastMatrix1[i * size + j - 1] +
+                                                lastMatrix1[(i - 1) * size + j] +
+                                                lastMatrix1[(i + 1) * size + j]);
+            }
+        }
+
+        if ((iter + 1) % 1000 == 0) {
+            double t = omp_get_wtime();
+            if (blas) {
+                vecops::axpy(len, coef, matrix1, lastMatrix1);
+                size_t idx = vecops::iamax(len, lastMatrix1);
+                error = std::fabs(lastMatrix1[idx]);
+                if (error > accuracy)
+                    vecops::copy(len, matrix1, lastMatrix1);
+            } else {
+                error = vecops::max_abs_diff(len, matrix1, lastMatrix1);
+                std::swap(matrix1, lastMatrix1);
+            }
+            checkTime += omp_get_wtime() - t;
+            if (error <= accuracy) break;
+        }
+        else {
+            std::swap(matrix1, lastMatrix1);
+        }
+        iter++;
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    auto time_s = std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
+    std::cout << "Iterations: " << iter + 1 << " error: " << error << std::endl;
+    std::cout << "Error checks: " << std::fixed << std::setprecision(3) << checkTime * 1000 << " ms ("
+              << (blas ? "axpy+iamax+copy" : "fused max_abs_diff") << ")" << std::endl;
+    std::cout << "Elapsed time: " << time_s << " milliseconds." << std::endl;
+
+    return 0;
+}
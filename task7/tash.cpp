@@ -7,6 +7,7 @@
 #include <boost/program_options.hpp>
 #include <vector>
 #include <chrono>
+#include "../common/grid_alloc.hpp"
 
 namespace opt = boost::program_options;
 
@@ -15,7 +16,7 @@ class Data {
 private:
     int len;
 public:
-    std::vector<ctype> arr;
+    grid_alloc::vector<ctype> arr;
     Data(int length) : len(length), arr(len) {
         #pragma acc enter data copyin(this)
         #pragma acc enter data create(arr[0:len])
@@ -31,11 +32,8 @@ double linearInterpolation(double x, double x1, double y1, double x2, double y2)
 }
 
 void init(Data<double>& matrix, int size) {
-    for (int i = 0; i < size; ++i) {
-        for (int j = 0; j < size; ++j) {
-            matrix.arr[i * size + j] = 0;
-        }
-    }
+    // arr is left uninitialised by its allocator; this is the first touch
+    grid_alloc::parallelFill(matrix.arr.data(), matrix.arr.size(), 0.0);
     matrix.arr[0] = 10.0;
     matrix.arr[size - 1] = 20.0;
     matrix.arr[(size - 1) * size + (size - 1)] = 30.0;
@@ -8,6 +8,9 @@
 #include <chrono>
 #include <cub/cub.cuh>
 #include <cuda_runtime.h>
+#include "../common/grid_io.hpp"
+#include "../common/grid_alloc.hpp"
+#include "../common/autotune.hpp"
 
 namespace opt = boost::program_options;
 
@@ -17,7 +20,7 @@ private:
     int len;
     ctype* d_arr;
 public:
-    std::vector<ctype> arr;
+    grid_alloc::vector<ctype> arr;
     Data(int length) : len(length), arr(len), d_arr(nullptr) {
         cudaError_t err = cudaMalloc((void**)&d_arr, len * sizeof(ctype));
         if (err != cudaSuccess) {
@@ -54,11 +57,8 @@ double linearInterpolation(double x, double x1, double y1, double x2, double y2)
 }
 
 void init(Data<double>& matrix, int size) {
-    for (int i = 0; i < size; ++i) {
-        for (int j = 0; j < size; ++j) {
-            matrix.arr[i * size + j] = 0;
-        }
-    }
+    // arr is left uninitialised by its allocator; this is the first touch
+    grid_alloc::parallelFill(matrix.arr.data(), matrix.arr.size(), 0.0);
     matrix.arr[0] = 10.0;
     matrix.arr[size - 1] = 20.0;
     matrix.arr[(size - 1) * size + (size - 1)] = 30.0;
@@ -87,14 +87,15 @@ __global__ void iterate(double* matrix, double* lastMatrix, int size) {
                                    lastMatrix[(i - 1) * size + j] + lastMatrix[(i + 1) * size + j]);
 }
 
-template <unsigned int blockSize>
+// BX x BY threads per block; cub::BlockReduce needs the shape at compile time.
+// Threads outside the grid still take part in the block reduction.
+template <unsigned int BX, unsigned int BY>
 __global__ void compute_error(double* matrix, double* lastMatrix, double* max_error, int size) {
     int j = blockIdx.x * blockDim.x + threadIdx.x;
     int i = blockIdx.y * blockDim.y + threadIdx.y;
 
-    if (j >= size || i >= size) return;
-
-    __shared__ typename cub::BlockReduce<double, blockSize>::TempStorage temp_storage;
+    typedef cub::BlockReduce<double, BX, cub::BLOCK_REDUCE_WARP_REDUCTIONS, BY> BlockReduce;
+    __shared__ typename BlockReduce::TempStorage temp_storage;
     double local_max = 0.0;
 
     if (j > 0 && i > 0 && j < size - 1 && i < size - 1) {
@@ -103,13 +104,60 @@ __global__ void compute_error(double* matrix, double* lastMatrix, double* max_er
         local_max = error;
     }
 
-    double block_max = cub::BlockReduce<double, blockSize>(temp_storage).Reduce(local_max, cub::Max());
+    double block_max = BlockReduce(temp_storage).Reduce(local_max, cub::Max());
 
     if (threadIdx.x == 0 && threadIdx.y == 0) {
         atomicMax(reinterpret_cast<unsigned long long*>(max_error), __double_as_longlong(block_max));
     }
 }
 
+// Block shapes the tuner may pick, 32 x 32 (the old fixed one) first.
+const std::vector<std::pair<int, int>> blockShapes = {{32, 32}, {32, 16}, {32, 8}, {64, 8}, {128, 4}, {16, 16}};
+
+void launch_error(dim3 grid, dim3 block, cudaStream_t stream, double* matrix, double* lastMatrix, double* max_error, int size) {
+    if (block.x == 32 && block.y == 16)
+        compute_error<32, 16><<<grid, block, 0, stream>>>(matrix, lastMatrix, max_error, size);
+    else if (block.x == 32 && block.y == 8)
+        compute_error<32, 8><<<grid, block, 0, stream>>>(matrix, lastMatrix, max_error, size);
+    else if (block.x == 64 && block.y == 8)
+        compute_error<64, 8><<<grid, block, 0, stream>>>(matrix, lastMatrix, max_error, size);
+    else if (block.x == 128 && block.y == 4)
+        compute_error<128, 4><<<grid, block, 0, stream>>>(matrix, lastMatrix, max_error, size);
+    else if (block.x == 16 && block.y == 16)
+        compute_error<16, 16><<<grid, block, 0, stream>>>(matrix, lastMatrix, max_error, size);
+    else
+        compute_error<32, 32><<<grid, block, 0, stream>>>(matrix, lastMatrix, max_error, size);
+}
+
+// The block shape for this size from the machine profile (common/autotune.hpp).
+// With AUTOTUNE=tune each shape first runs 100 sweeps and one error kernel on
+// scratch copies of the grid.
+dim3 tunedBlock(const Data<double>& matrix, int size) {
+    autotune::Space space = {{"shape", {0, 1, 2, 3, 4, 5}}};
+    if (autotune::mode() != autotune::Mode::Tune) {
+        int k = autotune::select("task8/jacobi", size, space, [](const autotune::Config&) {}).at("shape");
+        return dim3(blockShapes[k].first, blockShapes[k].second);
+    }
+    Data<double> a(size * size), b(size * size), err(1);
+    a.arr = matrix.arr;
+    b.arr = matrix.arr;
+    a.copyToDevice();
+    b.copyToDevice();
+    int k = autotune::select("task8/jacobi", size, space, [&](const autotune::Config& c) {
+        dim3 block(blockShapes[c.at("shape")].first, blockShapes[c.at("shape")].second);
+        dim3 grid((size + block.x - 1) / block.x, (size + block.y - 1) / block.y);
+        double* x = a.getDevicePointer();
+        double* y = b.getDevicePointer();
+        for (int s = 0; s < 100; s++) {
+            iterate<<<grid, block>>>(x, y, size);
+            std::swap(x, y);
+        }
+        launch_error(grid, block, 0, x, y, err.getDevicePointer(), size);
+        cudaDeviceSynchronize();
+    }).at("shape");
+    return dim3(blockShapes[k].first, blockShapes[k].second);
+}
+
 struct CudaGraphDeleter {
     void operator()(cudaGraph_t* graph) const {
         if (graph) {
@@ -163,6 +211,8 @@ int main(int argc, char const *argv[]) {
         ("accuracy", opt::value<double>(), "Accuracy")
         ("size", opt::value<int>(), "Size of matrix")
         ("count", opt::value<int>(), "Count of iterations")
+        ("output", opt::value<std::string>()->default_value("text"), "text (cuda.txt) or binary (cuda.grid)")
+        ("compress", opt::value<int>()->default_value(0), "zlib level for binary output, 0 = raw")
         ("help", "Help");
     opt::variables_map vm;
     opt::store(opt::parse_command_line(argc, argv, desc), vm);
@@ -189,9 +239,11 @@ int main(int argc, char const *argv[]) {
     error = accuracy + 1;
     int iter = 0;
 
-    dim3 blockDim(32, 32);
+    dim3 blockDim = tunedBlock(matrix, size);
+    std::cout << "block " << blockDim.x << " x " << blockDim.y << std::endl;
     dim3 gridDim((size + blockDim.x - 1) / blockDim.x, (size + blockDim.y - 1) / blockDim.y);
     Data<double> d_max_error(gridDim.x * gridDim.y);
+    std::fill(d_max_error.arr.begin(), d_max_error.arr.end(), 0.0);
     d_max_error.copyToDevice();
     matrix.copyToDevice();
     lastMatrix.copyToDevice();
@@ -220,7 +272,7 @@ while (iter < countIter && error > accuracy) {
         }
 
         iterate<<<gridDim, blockDim, 0, *stream>>>(matrix_link, lastMatrix_link, size);
-        compute_error<32><<<gridDim, blockDim, 0, *stream>>>(matrix_link, lastMatrix_link, d_max_error_link, size);
+        launch_error(gridDim, blockDim, *stream, matrix_link, lastMatrix_link, d_max_error_link, size);
 
         cudaStreamEndCapture(*stream, graph.get());
         cudaGraphInstantiate(graphExec.get(), *graph, nullptr, nullptr, 0);
@@ -254,7 +306,14 @@ while (iter < countIter && error > accuracy) {
     auto end = std::chrono::high_resolution_clock::now();
     auto time_s = std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
     std::cout << "Elapsed time: " << time_s << " milliseconds." << std::endl;
-    savematrix(matrix.arr.data(), size , "cuda.txt");
+    if (vm["output"].as<std::string>() == "binary") {
+        grid_io::WriteOptions wopt;
+        wopt.threads = std::thread::hardware_concurrency();
+        wopt.compress = vm["compress"].as<int>();
+        grid_io::writeGrid("cuda.grid", matrix.arr.data(), size, size, 1, wopt);
+    } else {
+        savematrix(matrix.arr.data(), size , "cuda.txt");
+    }
 
     return 0;
 }